@@ -0,0 +1,63 @@
+// include/hooks/binary_hooks.h
+#ifndef BINARY_HOOKS_H
+#define BINARY_HOOKS_H
+
+#include "sigtest.h"
+#include <stdint.h>
+
+/*
+   Compact binary result stream
+
+   The stream opens with a 8-byte header followed by length-prefixed records:
+
+      header:  "SGTB" | u16 version | u16 reserved
+      record:  u8 type | u32 payload length | payload
+
+   All integers are little-endian; strings are a u16 length followed by the raw bytes.
+   Readers must skip unknown record types and ignore trailing payload bytes they do not
+   understand, so fields can only ever be appended to a record. A stream may hold several
+   sets, and concatenated streams are valid: a header may follow any record.
+*/
+#define BINARY_STREAM_MAGIC "SGTB"
+#define BINARY_STREAM_VERSION 1
+#define BINARY_HEADER_SIZE 8
+#define BINARY_RECORD_HEADER_SIZE 5
+#define BINARY_BUFFER_SIZE 16384
+
+typedef enum
+{
+   REC_SET_START = 1,   // i32 sequence | i32 count | i64 timestamp | str name
+   REC_CASE_RESULT = 2, // u8 state | u8 flags | u64 duration_ns | str name | str message | u64 phase_ns[PHASE_COUNT] | str tags
+   REC_SET_SUMMARY = 3, // i32 total | i32 passed | i32 failed | i32 skipped | u64 config_ns | u64 cleanup_ns | i32 not_run
+   REC_MANIFEST_CASE = 4, // u32 id_hash | u8 flags | u64 timeout_ns | u64 expected_ns | str set | str name | str tags
+} BinaryRecordType;
+
+// REC_CASE_RESULT flags
+#define REC_FLAG_EXPECT_FAIL 0x01
+#define REC_FLAG_EXPECT_THROW 0x02
+// REC_MANIFEST_CASE flags, in addition to the above
+#define REC_FLAG_ISOLATED 0x04    // the set runs in fork workers
+#define REC_FLAG_HAS_HISTORY 0x08 // expected_ns is the body time of the case's last run
+
+struct BinaryHookContext
+{
+   FILE *stream; /* Output stream; falls back to the set log stream when NULL */
+   TestSet set;
+   FILE *header_stream; /* Stream the header was last written to */
+   int sequence; /* Test set sequence number */
+   size_t used;  /* Bytes pending in buffer */
+   unsigned char buffer[BINARY_BUFFER_SIZE];
+};
+
+extern struct sigtest_hooks_s binary_hooks;
+
+void binary_before_set(const TestSet set, object context);
+void binary_after_set(const TestSet set, object context);
+void binary_on_results_batch(const TestSet set, const TestCase *cases, int count, object context);
+/**
+ * @brief Writes any buffered records to the output stream
+ * @param context :the binary hook context
+ */
+void binary_flush(object context);
+
+#endif // BINARY_HOOKS_H
@@ -8,8 +8,6 @@ struct JsonHookContext
 {
    int count;
    int verbose;
-   ts_time start;
-   ts_time end;
    TestSet set;
 };
 
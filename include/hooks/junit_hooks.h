@@ -16,5 +16,6 @@ extern struct sigtest_hooks_s junit_hooks;
 void junit_before_set(const TestSet set, object context);
 void junit_after_set(const TestSet set, object context);
 void junit_on_test_result(const TestSet set, const TestCase tc, object context);
+void junit_on_results_batch(const TestSet set, const TestCase *cases, int count, object context);
 
 #endif // JUNIT_HOOKS_H
\ No newline at end of file
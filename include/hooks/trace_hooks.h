@@ -0,0 +1,39 @@
+// include/hooks/trace_hooks.h
+#ifndef TRACE_HOOKS_H
+#define TRACE_HOOKS_H
+
+#include "sigtest.h"
+
+/*
+   Chrome Trace Event export
+
+   Spans for set config, each case (with its setup, body and teardown) and set cleanup are
+   taken from the runner's phase timings and recorded into a per-thread event buffer. Each
+   thread only ever writes its own buffer; buffers are published to a shared list with a
+   single compare-and-swap, so recording takes no locks. Events are written out as one
+   Chrome Trace JSON document (chrome://tracing, ui.perfetto.dev) by `trace_flush`, which
+   also runs at exit. Each recording thread gets its own track; cases run by fork workers go
+   to one track per worker process.
+*/
+#define TRACE_CHUNK_EVENTS 1024
+#define TRACE_NAME_MAX 64
+
+struct TraceHookContext
+{
+   const char *path; /* Trace output file; stdout when NULL */
+   ts_tick origin;   /* Tick mapped to ts=0; the earliest set config when 0 */
+   int flushed;      /* Trace written */
+};
+
+extern struct sigtest_hooks_s trace_hooks;
+
+void trace_before_set(const TestSet set, object context);
+void trace_after_set(const TestSet set, object context);
+void trace_on_results_batch(const TestSet set, const TestCase *cases, int count, object context);
+/**
+ * @brief Writes all recorded events as a Chrome Trace JSON document
+ * @param context :the trace hook context
+ */
+void trace_flush(object context);
+
+#endif // TRACE_HOOKS_H
@@ -31,6 +31,8 @@ struct sigtest_logger_s;
 typedef void *object;
 typedef char *string;
 typedef struct timespec ts_time;
+typedef unsigned long long ts_tick; // Test clock ticks (TSC cycles or nanoseconds)
+typedef unsigned long long TagMask; // One bit per registered tag
 
 typedef struct sigtest_case_s *TestCase;
 typedef struct sigtest_set_s *TestSet;
@@ -76,9 +78,36 @@ typedef enum
 {
 	PASS,
 	FAIL,
-	SKIP
+	SKIP,
+	TIMEOUT, // the test body overran its timeout; counted as a failure
+	CRASH,	// the test body raised a fatal signal under the crash guard; counted as a failure
+	NOT_RUN, // the run was cancelled before the case ran; neither passed, failed nor skipped
 } TestState;
 
+/**
+ * @brief Test case phases timed by the runner
+ */
+typedef enum
+{
+	PHASE_BEFORE_TEST, // before_test and on_start_test hooks
+	PHASE_SETUP,		 // test case setup
+	PHASE_BODY,			 // test function
+	PHASE_TEARDOWN,	 // test case teardown
+	PHASE_AFTER_TEST,	 // on_end_test and after_test hooks
+	PHASE_RESULT,		 // expectation processing and result hooks
+	PHASE_COUNT
+} TestPhase;
+/**
+ * @brief Phase timing recorded by the runner
+ */
+typedef struct
+{
+	ts_tick start; /* Test clock tick at which the phase began */
+	double ns;		/* Phase duration in nanoseconds */
+} PhaseTiming;
+extern const char *TEST_PHASES[]; // Phase names, indexed by TestPhase
+extern const char *TEST_STATES[]; // State names, indexed by TestState
+
 /**
  * @brief Assert interface structure with function pointers
  */
@@ -177,7 +206,16 @@ typedef struct sigtest_case_s
 		TestState state;
 		string message;
 	} test_result;
-	TestCase next; /* Pointer to the next test case */
+	double timeout_ms;					 /* Test body timeout; 0 defers to the set, then the global timeout */
+	PhaseTiming timings[PHASE_COUNT]; /* Phase timings; PHASE_RESULT is complete only after `on_test_result` */
+	int worker;								 /* Pid of the fork worker that ran the case; 0 in-process */
+	TagMask tags;							 /* The case's tags, its set's included */
+	unsigned int id_hash;				 /* test_id_hash of the set and case names */
+	struct RepeatStats *repeat;		 /* Runs of a repeated case; NULL unless a repeat mode ran it */
+	double flip_rate;						 /* Flakiness from the result store; negative when unknown */
+	int quarantined;						 /* Flaky: a failure is reported but does not fail the run */
+	int attempts;							 /* Runs this run; more than 1 when a quarantined failure was retried */
+	TestCase next;							 /* Pointer to the next test case */
 } sigtest_case_s;
 
 /**
@@ -195,20 +233,29 @@ typedef struct sigtest_logger_s
 typedef struct sigtest_set_s
 {
 	string name;			/* Test set name */
+	ConfigFunc config;	/* Test set config function; run when the set is about to run, then NULL */
 	CleanupFunc cleanup; /* Test set cleanup function */
 	CaseOp setup;			/* Test case setup function */
 	CaseOp teardown;		/* Test case teardown function */
 	FILE *log_stream;		/* Log stream for the test set */
 	TestCase cases;		/* Pointer to the test cases */
 	TestCase tail;			/* Pointer to the last test case */
+	TestCase filtered;	/* Test cases left out by the run's filter */
 	int count;				/* Number of test cases */
 	int passed;				/* Number of passed test cases */
 	int failed;				/* Number of failed test cases */
 	int skipped;			/* Number of skipped test cases */
+	int not_run;			/* Number of test cases cancelled before they ran */
+	int quarantined;		/* Number of quarantined test cases that failed */
 	TestCase current;		/* Current test case */
 	TestSet next;			/* Pointer to the next test set */
 	SigtestHooks hooks;	/* Hooks for the test set */
 	Logger logger;			/* Logger for the test set */
+	PhaseTiming config_time;  /* Test set config timing */
+	PhaseTiming cleanup_time; /* Test set cleanup timing; complete before `after_set` */
+	double timeout_ms;		  /* Default test body timeout for the set's cases; 0 for none */
+	int fork_batch;			  /* Cases per forked child; 0 runs the set in-process */
+	TagMask tags;				  /* Tags given to every case of the set */
 } sigtest_set_s;
 
 /**
@@ -234,6 +281,23 @@ void fail_testcase(string name, void (*func)(void));
  * @param  func :the test function
  */
 void testcase_throws(string name, void (*func)(void));
+/**
+ * @brief Registers a new test with tags
+ * @param  name :the test name
+ * @param  func :the test function
+ * @param  tags :comma-separated tag names, e.g. "fast,db"
+ */
+void testcase_tagged(string name, void (*func)(void), const char *tags);
+/**
+ * @brief Tags the most recently registered test case
+ * @param  tags :comma-separated tag names of letters, digits, `_`, `-`, `.` and `:`
+ */
+void tag_testcase(const char *tags);
+/**
+ * @brief Tags the current test set; its cases, registered before or after, carry the tags
+ * @param  tags :comma-separated tag names of letters, digits, `_`, `-`, `.` and `:`
+ */
+void tag_testset(const char *tags);
 /**
  * @brief Registers the test case setup function
  * @param  setup :the test case setup function
@@ -244,9 +308,32 @@ void setup_testcase(void (*setup)(void));
  * @param  teardown :the test case teardown function
  */
 void teardown_testcase(void (*teardown)(void));
+/**
+ * @brief Looks up a registered test case by its stable id
+ * @param  set :the test set name
+ * @param  name :the test case name
+ * @param  owner :receives the case's test set; may be NULL
+ * @return the test case, or NULL when no case is registered under the id
+ */
+TestCase find_testcase(const char *set, const char *name, TestSet *owner);
+/**
+ * @brief Sets the timeout of the most recently registered test case
+ * @param  ms :the test body timeout in milliseconds; 0 defers to the set timeout
+ */
+void timeout_testcase(double ms);
+/**
+ * @brief Sets the default timeout for the current test set's cases
+ * @param  ms :the test body timeout in milliseconds; 0 defers to the global timeout
+ */
+void timeout_testset(double ms);
+/**
+ * @brief Runs the current test set's cases in fork workers that see the configured set copy-on-write
+ * @param  cases_per_child :cases run by each worker before it is recycled; 0 runs the set in-process
+ */
+void isolate_testset(int cases_per_child);
 /**
  * @brief Registers the test set config & cleanup function
- * @param  config :the test set config function
+ * @param  config :the test set config function; runs just before the set, and not at all when no case is selected
  * @param  cleanup :the test set cleanup function
  */
 void testset(string name, void (*config)(FILE **), void (*cleanup)(void));
@@ -289,21 +376,161 @@ void fwritelnf(FILE *, const char *, ...);
  * @param format :strftime format string (e.g., "%Y-%m-%dT%H:%M:%S")
  */
 void get_timestamp(char *, const char *);
+/**
+ * @brief Hashes a test's stable id, its set and case names
+ * @param set :the test set name
+ * @param name :the test case name
+ * @return the 32-bit id hash
+ */
+unsigned int test_id_hash(const char *set, const char *name);
+/**
+ * @brief Calibrates the test clock; invariant TSC when available, else clock_gettime
+ * @detail Called lazily on first use; calling it up front keeps calibration out of timings
+ */
+void sys_clock_init(void);
+/**
+ * @brief Reads the test clock
+ * @return the current clock tick
+ */
+ts_tick sys_getticks(void);
+/**
+ * @brief Converts a tick interval to nanoseconds less the measured timer overhead
+ * @param start :the starting tick
+ * @param end :the ending tick
+ * @return elapsed nanoseconds (never negative)
+ */
+double get_elapsed_ns(ts_tick, ts_tick);
+/**
+ * @brief Retrieve the active test clock source: "tsc" or "clock_gettime"
+ */
+const char *sys_clock_source(void);
+
+/**
+ * @brief Start the SIGPROF sampling profiler; samples are attributed to the running test case
+ * @param path :the folded stack output file
+ * @param hz :the sampling frequency; a default is used when 0
+ * @param threshold_us :only keep samples of cases whose body ran at least this long
+ * @return 0 on success, -1 on error
+ */
+int profile_start(const char *path, int hz, double threshold_us);
+/**
+ * @brief Stop the profiler and write folded stacks (`set;case;frame;...;leaf count`)
+ */
+void profile_stop(void);
+/**
+ * @brief Attribute samples to a test case; called by the runner around the test body
+ * @param set :the running test set
+ * @param tc :the running test case
+ * @param top :the runner's frame address; the unwinder stops there
+ */
+void profile_enter_case(TestSet set, TestCase tc, void *top);
+/**
+ * @brief Stop attributing samples; samples of cases under the threshold are dropped
+ * @param elapsed_ns :the test body duration
+ */
+void profile_leave_case(double elapsed_ns);
+
+/**
+ * @brief Arm the calling thread's watchdog; `expire` runs from the timeout signal handler
+ * @param ms :the timeout in milliseconds; nothing is armed when 0
+ * @param expire :the expiry callback; expected to jump back to the runner
+ * @return 0 on success, -1 on error
+ */
+int timeout_arm(double ms, void (*expire)(void));
+/**
+ * @brief Disarm the calling thread's watchdog
+ */
+void timeout_disarm(void);
+/**
+ * @brief Install the crash guard: SIGSEGV/SIGBUS/SIGFPE/SIGABRT handlers on an alternate stack
+ * @return 0 on success, -1 on error
+ */
+int crash_guard_install(void);
+/**
+ * @brief Contain crashes on the calling thread; `crashed` runs from the signal handler
+ * @param crashed :the crash callback; expected to jump back to the runner
+ */
+void crash_arm(void (*crashed)(void));
+/**
+ * @brief Stop containing crashes on the calling thread
+ */
+void crash_disarm(void);
+/**
+ * @brief Describe the last contained crash (signal, address, innermost frames)
+ * @param buffer :the message buffer
+ * @param size :the buffer size
+ */
+void crash_describe(char *buffer, size_t size);
+
+// Tags: at most SIGTEST_MAX_TAGS names (one TagMask bit each) of under SIGTEST_TAG_MAX characters
+#define SIGTEST_MAX_TAGS 64
+#define SIGTEST_TAG_MAX 32
+
+/**
+ * @brief Register tag names
+ * @param tags :comma-separated tag names
+ * @return the mask of the named tags
+ */
+TagMask tag_mask(const char *tags);
+/**
+ * @brief Write the names of a tag mask, comma-separated
+ * @param tags :the tag mask
+ * @param buffer :receives the names
+ * @param size :the buffer size
+ * @return the length written
+ */
+int tag_names(TagMask tags, char *buffer, size_t size);
+
+// Repeat modes: body time histogram buckets (powers of two nanoseconds) and the failure message kept
+#define REPEAT_BUCKETS 40
+#define REPEAT_MESSAGE_MAX 256
+/**
+ * @brief Outcome of a case run many times by `--repeat`, `--repeat-for` or `--until-fail`
+ * @detail The case is reported once, as its first failure when it had one; its body time
+ *         is then the mean of its runs.
+ */
+typedef struct RepeatStats
+{
+	unsigned long long runs;
+	unsigned long long states[NOT_RUN];				/* Runs ending in each state */
+	unsigned long long failures;						/* Runs that broke the case's expectation */
+	unsigned long long first_failure;				/* Run number of the first failure; 0 for none */
+	TestState failure;									/* State of the first failure */
+	double min_ns, max_ns, total_ns;					/* Body time */
+	unsigned long long histogram[REPEAT_BUCKETS]; /* Bucket b counts bodies under 2^b ns, from 2^(b-1) */
+	char message[REPEAT_MESSAGE_MAX];				/* Message of the first failure */
+} RepeatStats;
+/**
+ * @brief Estimate a body time percentile from the histogram
+ * @param stats :the repeat stats
+ * @param fraction :the percentile as a fraction, e.g. 0.99
+ * @return the upper bound of the bucket holding the percentile, capped at the slowest body, in ns
+ */
+double repeat_percentile(const RepeatStats *stats, double fraction);
+
+// Batched result delivery: default and maximum results per `on_results_batch` call
+#define SIGTEST_BATCH_SIZE 64
+#define SIGTEST_MAX_BATCH 256
 
 /**
  * @brief Test hooks structure
+ * @detail `on_results_batch` receives completed test cases every `batch_size` results and
+ *         at the end of each set, before `after_set`; reporters that only need results can
+ *         leave the per-event callbacks NULL.
  */
 typedef struct sigtest_hooks_s
 {
 	const char *name;																// Hooks label
 	void (*before_set)(const TestSet, object);							// Called before each test set
-	void (*after_set)(const TestSet, object);								// Called after each test set
+	void (*after_set)(const TestSet, object);								// Called after each test set, once its cleanup has run
 	void (*before_test)(object);												// Called before each test case
 	void (*after_test)(object);												// Called after each test case
 	void (*on_start_test)(object);											// Callback at the start of a test
 	void (*on_end_test)(object);												// Callback at the end of a test
 	void (*on_error)(const char *, object);								// Callback on error
 	void (*on_test_result)(const TestSet, const TestCase, object); // Callback on test result
+	void (*on_results_batch)(const TestSet, const TestCase *, int, object); // Callback with a batch of test results
+	int batch_size;																	// Results per batch; 0 uses SIGTEST_BATCH_SIZE
 	void *context;																	// User-defined data
 } sigtest_hooks_s;
 /**
@@ -320,6 +547,20 @@ typedef struct hook_registry_s
  * @return pointer to the initialized SigtestHooks
  */
 SigtestHooks init_hooks(const char *);
+/**
+ * @brief Initialize fan-out hooks that dispatch every event to each member hook set
+ * @param name :the fan-out hooks label
+ * @return pointer to the initialized SigtestHooks
+ */
+SigtestHooks init_fanout_hooks(const char *);
+/**
+ * @brief Adds member hooks to fan-out hooks; members are called in the order added
+ * @param fanout :the fan-out hooks
+ * @param hooks :the member hooks, called with their own context
+ * @param stream :the member output stream; NULL writes to the set log stream
+ * @return 0 on success, -1 on failure
+ */
+int fanout_add_hooks(SigtestHooks, SigtestHooks, FILE *);
 
 /**
  * @brief Registers a test set with the given name
@@ -328,5 +569,11 @@ SigtestHooks init_hooks(const char *);
  * @return 0 if all tests pass, 1 if any test fails
  */
 int run_tests(TestSet, SigtestHooks);
+/**
+ * @brief Apply a runner option given as `--name[=value]`; each sets its SIGTEST_* environment variable
+ * @param arg :the command line argument
+ * @return 1 when applied, 0 when `arg` is not a runner option, -1 when its value is missing
+ */
+int sigtest_option(const char *arg);
 
 #endif // SIGTEST_H
@@ -0,0 +1,165 @@
+// src/hooks/binary_hooks.c
+#include "hooks/binary_hooks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+   Test hooks for compact binary result streams.
+
+   Records are encoded into the context buffer and written out in bulk; use
+   `tools/sigconvert` to turn a stream into the JSON or JUnit layouts.
+
+   David Boarman
+*/
+
+struct sigtest_hooks_s binary_hooks = {
+    .name = "binary_hooks",
+    .before_set = binary_before_set,
+    .after_set = binary_after_set,
+    .before_test = NULL,
+    .after_test = NULL,
+    .on_start_test = NULL,
+    .on_end_test = NULL,
+    .on_error = NULL,
+    .on_test_result = NULL,
+    .on_results_batch = binary_on_results_batch,
+    .batch_size = SIGTEST_BATCH_SIZE,
+    .context = NULL,
+};
+
+//	encoding helpers
+static FILE *binary_stream(struct BinaryHookContext *ctx)
+{
+   if (ctx->stream)
+      return ctx->stream;
+
+   return ctx->set && ctx->set->log_stream ? ctx->set->log_stream : stdout;
+}
+static void put_u8(struct BinaryHookContext *ctx, uint8_t value)
+{
+   ctx->buffer[ctx->used++] = value;
+}
+static void put_u16(struct BinaryHookContext *ctx, uint16_t value)
+{
+   ctx->buffer[ctx->used++] = value & 0xFF;
+   ctx->buffer[ctx->used++] = (value >> 8) & 0xFF;
+}
+static void put_u32(struct BinaryHookContext *ctx, uint32_t value)
+{
+   for (int i = 0; i < 4; i++)
+      ctx->buffer[ctx->used++] = (value >> (i * 8)) & 0xFF;
+}
+static void put_u64(struct BinaryHookContext *ctx, uint64_t value)
+{
+   for (int i = 0; i < 8; i++)
+      ctx->buffer[ctx->used++] = (value >> (i * 8)) & 0xFF;
+}
+static void put_str(struct BinaryHookContext *ctx, const char *str, size_t max)
+{
+   size_t len = str ? strlen(str) : 0;
+   if (len > max)
+      len = max;
+   put_u16(ctx, (uint16_t)len);
+   memcpy(ctx->buffer + ctx->used, str, len);
+   ctx->used += len;
+}
+// reserve room for a record of at most `size` payload bytes; returns the payload offset
+static size_t begin_record(struct BinaryHookContext *ctx, BinaryRecordType type, size_t size)
+{
+   if (ctx->used + BINARY_RECORD_HEADER_SIZE + size > sizeof(ctx->buffer))
+      binary_flush(ctx);
+
+   put_u8(ctx, (uint8_t)type);
+   put_u32(ctx, 0); // patched by end_record
+   return ctx->used;
+}
+static void end_record(struct BinaryHookContext *ctx, size_t offset)
+{
+   uint32_t len = (uint32_t)(ctx->used - offset);
+   for (int i = 0; i < 4; i++)
+      ctx->buffer[offset - 4 + i] = (len >> (i * 8)) & 0xFF;
+}
+
+void binary_flush(object context)
+{
+   struct BinaryHookContext *ctx = context;
+   if (!ctx->used)
+      return;
+
+   FILE *stream = binary_stream(ctx);
+   if (fwrite(ctx->buffer, 1, ctx->used, stream) != ctx->used)
+   {
+      fwritelnf(stderr, "Error: Failed to write binary result stream");
+   }
+   fflush(stream);
+   ctx->used = 0;
+}
+void binary_before_set(const TestSet set, object context)
+{
+   struct BinaryHookContext *ctx = context;
+   ctx->set = set;
+   ctx->sequence++;
+
+   // every output stream opens with a header; without a shared stream each set logs to its own,
+   // and a reopened log may reuse the FILE of the last one, so an empty file gets one too
+   FILE *stream = binary_stream(ctx);
+   if (stream != ctx->header_stream || ftell(stream) == 0)
+   {
+      memcpy(ctx->buffer + ctx->used, BINARY_STREAM_MAGIC, 4);
+      ctx->used += 4;
+      put_u16(ctx, BINARY_STREAM_VERSION);
+      put_u16(ctx, 0);
+      ctx->header_stream = stream;
+   }
+
+   // names are capped so a record always fits the buffer
+   size_t offset = begin_record(ctx, REC_SET_START, 16 + 2 + 1024);
+   put_u32(ctx, (uint32_t)ctx->sequence);
+   put_u32(ctx, (uint32_t)set->count);
+   put_u64(ctx, (uint64_t)time(NULL));
+   put_str(ctx, set->name, 1024);
+   end_record(ctx, offset);
+}
+void binary_after_set(const TestSet set, object context)
+{
+   struct BinaryHookContext *ctx = context;
+
+   size_t offset = begin_record(ctx, REC_SET_SUMMARY, 16 + 16 + 4);
+   put_u32(ctx, (uint32_t)set->count);
+   put_u32(ctx, (uint32_t)set->passed);
+   put_u32(ctx, (uint32_t)set->failed);
+   put_u32(ctx, (uint32_t)set->skipped);
+   put_u64(ctx, (uint64_t)set->config_time.ns);
+   put_u64(ctx, (uint64_t)set->cleanup_time.ns);
+   put_u32(ctx, (uint32_t)set->not_run);
+   end_record(ctx, offset);
+
+   binary_flush(ctx);
+   ctx->set = NULL;
+}
+//	results arrive in batches once every phase, result processing included, has been timed
+void binary_on_results_batch(const TestSet set, const TestCase *cases, int count, object context)
+{
+   struct BinaryHookContext *ctx = context;
+
+   for (int i = 0; i < count; i++)
+   {
+      TestCase tc = cases[i];
+      uint8_t flags = (tc->expect_fail ? REC_FLAG_EXPECT_FAIL : 0) | (tc->expect_throw ? REC_FLAG_EXPECT_THROW : 0);
+
+      char tags[512];
+      tag_names(tc->tags, tags, sizeof(tags));
+
+      size_t offset = begin_record(ctx, REC_CASE_RESULT, 10 + 6 + 1024 + 1024 + 8 * PHASE_COUNT + sizeof(tags));
+      put_u8(ctx, (uint8_t)tc->test_result.state);
+      put_u8(ctx, flags);
+      put_u64(ctx, (uint64_t)tc->timings[PHASE_BODY].ns);
+      put_str(ctx, tc->name, 1024);
+      put_str(ctx, tc->test_result.message, 1024);
+      for (int phase = 0; phase < PHASE_COUNT; phase++)
+         put_u64(ctx, (uint64_t)tc->timings[phase].ns);
+      put_str(ctx, tags, sizeof(tags));
+      end_record(ctx, offset);
+   }
+}
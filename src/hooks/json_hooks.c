@@ -10,9 +10,6 @@
    David Boarman
  */
 
-extern double get_elapsed_ms(ts_time *, ts_time *);
-extern int sys_gettime(ts_time *);
-
 struct sigtest_hooks_s json_hooks = {
     .name = "json_hooks",
     .before_set = json_before_set,
@@ -23,6 +20,8 @@ struct sigtest_hooks_s json_hooks = {
     .on_end_test = json_on_end_test,
     .on_error = json_on_error,
     .on_test_result = json_on_test_result,
+    .on_results_batch = NULL,
+    .batch_size = 0,
     .context = NULL,
 };
 
@@ -45,7 +44,10 @@ void json_after_set(const TestSet set, object context)
    set->logger->log("    \"total\": %d,\n", set->count);
    set->logger->log("    \"passed\": %d,\n", set->passed);
    set->logger->log("    \"failed\": %d,\n", set->failed);
-   set->logger->log("    \"skipped\": %d\n", set->skipped);
+   set->logger->log("    \"skipped\": %d,\n", set->skipped);
+   set->logger->log("    \"not_run\": %d,\n", set->not_run);
+   set->logger->log("    \"config_us\": %.3f,\n", set->config_time.ns / 1000.0);
+   set->logger->log("    \"cleanup_us\": %.3f\n", set->cleanup_time.ns / 1000.0);
    set->logger->log("  }\n");
    set->logger->log("}\n");
 }
@@ -61,15 +63,6 @@ void json_on_start_test(object context)
 {
    struct JsonHookContext *ctx = context;
 
-   ctx->end.tv_sec = 0;
-   ctx->end.tv_nsec = 0;
-
-   if (sys_gettime(&ctx->start) == -1)
-   {
-      fwritelnf(stderr, "Error: Failed to get system start time");
-      exit(EXIT_FAILURE);
-   }
-
    if (ctx->verbose && ctx->set)
    {
       ctx->set->logger->log("    \"start_test\": \"%s\",\n", ctx->set->current->name);
@@ -79,12 +72,6 @@ void json_on_end_test(object context)
 {
    struct JsonHookContext *ctx = context;
 
-   if (sys_gettime(&ctx->end) == -1)
-   {
-      fwritelnf(stderr, "Error: Failed to get system end time");
-      exit(EXIT_FAILURE);
-   }
-
    if (ctx->verbose && ctx->set)
    {
       ctx->set->logger->log("    \"end_test\": \"%s\",\n", ctx->set->current->name);
@@ -110,8 +97,6 @@ void json_on_error(const char *message, object context)
 }
 void json_on_test_result(const TestSet set, const TestCase tc, object context)
 {
-   struct JsonHookContext *ctx = context;
-
    // get test state label
    const char *status = NULL;
    switch (tc->test_result.state)
@@ -125,18 +110,24 @@ void json_on_test_result(const TestSet set, const TestCase tc, object context)
    case SKIP:
       status = "SKIP";
       break;
+   case TIMEOUT:
+      status = "TIMEOUT";
+      break;
+   case CRASH:
+      status = "CRASH";
+      break;
+   case NOT_RUN:
+      status = "NOT_RUN";
+      break;
    default:
       status = "UNKNOWN";
       break;
    }
 
    // Output test result in JSON format
-   double elapsed_ms = get_elapsed_ms(&ctx->start, &ctx->end);
-   char duration_str[16];
-   if (elapsed_ms < 0.0001)
-      snprintf(duration_str, sizeof(duration_str), "< 0.1");
-   else
-      snprintf(duration_str, sizeof(duration_str), "%.3f", elapsed_ms * 1000.0);
+   double elapsed_ns = tc->timings[PHASE_BODY].ns;
+   char duration_str[32];
+   snprintf(duration_str, sizeof(duration_str), "%.3f", elapsed_ns / 1000.0);
 
    char message[256];
    snprintf(message, sizeof(message), "%s", tc->test_result.message ? tc->test_result.message : "");
@@ -153,7 +144,74 @@ void json_on_test_result(const TestSet set, const TestCase tc, object context)
    set->logger->log("    {\n");
    set->logger->log("      \"test\": \"%s\",\n", tc->name);
    set->logger->log("      \"status\": \"%s\",\n", status);
+   if (tc->tags)
+   {
+      char names[512];
+      tag_names(tc->tags, names, sizeof(names));
+      char tags[1024];
+      dst = tags;
+      for (const char *src = names; *src && dst < tags + sizeof(tags) - 2; src++)
+      {
+         if (*src == '"')
+            *dst++ = '\\';
+         *dst++ = *src;
+      }
+      *dst = '\0';
+      set->logger->log("      \"tags\": [");
+      char *next = NULL;
+      for (char *tag = strtok_r(tags, ",", &next); tag; tag = strtok_r(NULL, ",", &next))
+      {
+         set->logger->log("%s\"%s\"", tag == tags ? "" : ", ", tag);
+      }
+      set->logger->log("],\n");
+   }
+   // flakiness is known once the result store holds enough runs of the current body
+   if (tc->flip_rate >= 0.0)
+   {
+      set->logger->log("      \"flip_rate\": %.3f,\n", tc->flip_rate);
+   }
+   if (tc->quarantined)
+   {
+      set->logger->log("      \"quarantined\": true,\n");
+   }
+   if (tc->attempts > 1)
+   {
+      set->logger->log("      \"attempts\": %d,\n", tc->attempts);
+   }
    set->logger->log("      \"duration_us\": \"%s\",\n", duration_str);
+   // result processing is still under way, so its phase is not reported here
+   set->logger->log("      \"phases_us\": {");
+   for (int phase = PHASE_BEFORE_TEST; phase < PHASE_RESULT; phase++)
+   {
+      set->logger->log("%s\"%s\": %.3f", phase ? ", " : "", TEST_PHASES[phase], tc->timings[phase].ns / 1000.0);
+   }
+   set->logger->log("},\n");
+   // a repeated case stands for all its runs: how they ended and their body time histogram
+   if (tc->repeat)
+   {
+      RepeatStats *stats = tc->repeat;
+      set->logger->log("      \"repeat\": {\"runs\": %llu, \"failures\": %llu, \"first_failure\": %llu, \"states\": {",
+                       stats->runs, stats->failures, stats->first_failure);
+      for (int state = PASS; state < NOT_RUN; state++)
+      {
+         set->logger->log("%s\"%s\": %llu", state ? ", " : "", TEST_STATES[state], stats->states[state]);
+      }
+      set->logger->log("}, \"min_us\": %.3f, \"p50_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f",
+                       stats->min_ns / 1000.0, repeat_percentile(stats, 0.5) / 1000.0,
+                       repeat_percentile(stats, 0.9) / 1000.0, repeat_percentile(stats, 0.99) / 1000.0,
+                       stats->max_ns / 1000.0);
+      set->logger->log(", \"histogram\": [");
+      int first = 1;
+      for (int bucket = 0; bucket < REPEAT_BUCKETS; bucket++)
+      {
+         if (!stats->histogram[bucket])
+            continue;
+         set->logger->log("%s{\"under_us\": %.3f, \"count\": %llu}", first ? "" : ", ", (1ULL << bucket) / 1000.0,
+                          stats->histogram[bucket]);
+         first = 0;
+      }
+      set->logger->log("]},\n");
+   }
    set->logger->log("      \"message\": \"%s\"\n", escaped_message);
    set->logger->log("    }%s\n", tc->next ? "," : "");
 }
\ No newline at end of file
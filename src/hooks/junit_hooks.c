@@ -19,7 +19,9 @@ struct sigtest_hooks_s junit_hooks = {
     .on_start_test = NULL,
     .on_end_test = NULL,
     .on_error = NULL,
-    .on_test_result = junit_on_test_result,
+    .on_test_result = NULL,
+    .on_results_batch = junit_on_results_batch,
+    .batch_size = 0,
     .context = NULL,
 };
 
@@ -44,8 +46,38 @@ void junit_after_set(const TestSet set, object context)
 
 void junit_on_test_result(const TestSet set, const TestCase tc, object context)
 {
-   set->logger->log("<testcase name=\"%s\">\n", tc->name);
-   if (tc->test_result.state == FAIL)
+   set->logger->log("<testcase name=\"%s\" time=\"%.6f\">\n", tc->name, tc->timings[PHASE_BODY].ns / 1e9);
+   if (tc->tags || tc->quarantined || tc->attempts > 1)
+   {
+      set->logger->log("<properties>");
+      if (tc->tags)
+      {
+         char names[512];
+         tag_names(tc->tags, names, sizeof(names));
+         char tags[1024];
+         char *dst = tags;
+         for (const char *src = names; *src && dst < tags + sizeof(tags) - 2; src++)
+         {
+            if (*src == '"')
+               *dst++ = '\\';
+            *dst++ = *src;
+         }
+         *dst = '\0';
+         set->logger->log("<property name=\"tags\" value=\"%s\"/>", tags);
+      }
+      // a quarantined failure is still reported as one; consumers can tell it apart by these
+      if (tc->quarantined)
+      {
+         set->logger->log("<property name=\"quarantined\" value=\"true\"/>");
+         set->logger->log("<property name=\"flip_rate\" value=\"%.3f\"/>", tc->flip_rate);
+      }
+      if (tc->attempts > 1)
+      {
+         set->logger->log("<property name=\"attempts\" value=\"%d\"/>", tc->attempts);
+      }
+      set->logger->log("</properties>\n");
+   }
+   if (tc->test_result.state == FAIL || tc->test_result.state == TIMEOUT || tc->test_result.state == CRASH)
    {
       char escaped[512];
       char *dst = escaped;
@@ -63,5 +95,17 @@ void junit_on_test_result(const TestSet set, const TestCase tc, object context)
    {
       set->logger->log("<skipped/>\n");
    }
+   else if (tc->test_result.state == NOT_RUN)
+   {
+      // JUnit has no not-run outcome; a skip that says why is the closest
+      set->logger->log("<skipped message=\"%s\"/>\n", tc->test_result.message ? tc->test_result.message : "Not run");
+   }
    set->logger->log("</testcase>\n");
-}
\ No newline at end of file
+}
+void junit_on_results_batch(const TestSet set, const TestCase *cases, int count, object context)
+{
+   for (int i = 0; i < count; i++)
+   {
+      junit_on_test_result(set, cases[i], context);
+   }
+}
@@ -0,0 +1,240 @@
+// src/hooks/trace_hooks.c
+#include "hooks/trace_hooks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+   Test hooks for Chrome Trace Event output.
+
+   Recording only copies a few fields into the calling thread's chunk; formatting and
+   file I/O are deferred to `trace_flush` so they stay out of the timings being traced.
+
+   David Boarman
+*/
+
+typedef struct
+{
+   char name[TRACE_NAME_MAX];
+   char set[TRACE_NAME_MAX];
+   const char *cat;   /* Static category label */
+   const char *state; /* Static test state label; NULL for set spans */
+   double ts_us;      /* Start, relative to the trace origin */
+   double dur_us;
+   int worker;        /* Fork worker that ran the span; 0 for the recording thread */
+} TraceEvent;
+
+typedef struct TraceChunk
+{
+   struct TraceChunk *next; /* Next published chunk */
+   int tid;                 /* Recording thread */
+   int first;               /* First chunk of its thread; carries the track name */
+   int used;
+   TraceEvent events[TRACE_CHUNK_EVENTS];
+} TraceChunk;
+
+struct sigtest_hooks_s trace_hooks = {
+    .name = "trace_hooks",
+    .before_set = trace_before_set,
+    .after_set = trace_after_set,
+    .before_test = NULL,
+    .after_test = NULL,
+    .on_start_test = NULL,
+    .on_end_test = NULL,
+    .on_error = NULL,
+    .on_test_result = NULL,
+    .on_results_batch = trace_on_results_batch,
+    .batch_size = SIGTEST_BATCH_SIZE,
+    .context = NULL,
+};
+
+static TraceChunk *published = NULL;        // every chunk ever filled, newest first
+static __thread TraceChunk *local = NULL;   // the calling thread's current chunk
+static __thread ts_tick set_start = 0;      // start of the set being run on this thread
+static struct TraceHookContext *exit_context = NULL;
+
+static void trace_at_exit(void)
+{
+   if (exit_context)
+      trace_flush(exit_context);
+}
+//	claim a slot in this thread's chunk; a full chunk is replaced, never grown
+static TraceEvent *trace_event(void)
+{
+   if (!local || local->used == TRACE_CHUNK_EVENTS)
+   {
+      TraceChunk *chunk = malloc(sizeof(TraceChunk));
+      if (!chunk)
+         return NULL;
+      chunk->tid = (int)syscall(SYS_gettid);
+      chunk->first = local == NULL;
+      chunk->used = 0;
+
+      // publish with a single CAS; readers only walk the list at flush time
+      chunk->next = __atomic_load_n(&published, __ATOMIC_RELAXED);
+      while (!__atomic_compare_exchange_n(&published, &chunk->next, chunk, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+         ;
+      local = chunk;
+   }
+
+   return &local->events[local->used++];
+}
+static double trace_us(struct TraceHookContext *ctx, ts_tick tick)
+{
+   return get_elapsed_ns(ctx->origin, tick) / 1000.0;
+}
+static void trace_span(struct TraceHookContext *ctx, const char *cat, const char *name, const TestSet set,
+                       const char *state, int worker, ts_tick start, double ns)
+{
+   // phases that never ran were never stamped
+   if (!start)
+      return;
+
+   TraceEvent *event = trace_event();
+   if (!event)
+      return;
+   snprintf(event->name, sizeof(event->name), "%s", name ? name : "");
+   snprintf(event->set, sizeof(event->set), "%s", set && set->name ? set->name : "");
+   event->cat = cat;
+   event->state = state;
+   event->ts_us = trace_us(ctx, start);
+   event->dur_us = ns / 1000.0;
+   event->worker = worker;
+}
+static void write_json_str(FILE *out, const char *str)
+{
+   for (; *str; str++)
+   {
+      if (*str == '"' || *str == '\\')
+         fputc('\\', out);
+      fputc((unsigned char)*str < 0x20 ? ' ' : *str, out);
+   }
+}
+//	note a fork worker's track; returns TRUE the first time it is seen
+static int worker_track(int **workers, int *count, int *size, int worker)
+{
+   for (int i = 0; i < *count; i++)
+   {
+      if ((*workers)[i] == worker)
+         return FALSE;
+   }
+   if (*count == *size)
+   {
+      int grown = *size ? *size * 2 : 16;
+      int *resized = realloc(*workers, sizeof(int) * grown);
+      if (!resized)
+         return FALSE;
+      *workers = resized;
+      *size = grown;
+   }
+   (*workers)[(*count)++] = worker;
+
+   return TRUE;
+}
+
+void trace_before_set(const TestSet set, object context)
+{
+   struct TraceHookContext *ctx = context;
+
+   if (!ctx->origin)
+   {
+      // sets are configured just before they run; the trace starts at the earliest config
+      for (TestSet each = test_sets; each; each = each->next)
+      {
+         if (each->config_time.start && (!ctx->origin || each->config_time.start < ctx->origin))
+            ctx->origin = each->config_time.start;
+      }
+      if (!ctx->origin)
+         ctx->origin = sys_getticks();
+   }
+   if (!exit_context)
+   {
+      exit_context = ctx;
+      atexit(trace_at_exit);
+   }
+
+   trace_span(ctx, "set", "config", set, NULL, 0, set->config_time.start, set->config_time.ns);
+   set_start = sys_getticks();
+}
+void trace_after_set(const TestSet set, object context)
+{
+   struct TraceHookContext *ctx = context;
+
+   // cleanup has already run; the set span closes with it
+   trace_span(ctx, "set", "cleanup", set, NULL, 0, set->cleanup_time.start, set->cleanup_time.ns);
+   trace_span(ctx, "set", set->name, set, NULL, 0, set_start, get_elapsed_ns(set_start, sys_getticks()));
+}
+void trace_on_results_batch(const TestSet set, const TestCase *cases, int count, object context)
+{
+   struct TraceHookContext *ctx = context;
+
+   for (int i = 0; i < count; i++)
+   {
+      TestCase tc = cases[i];
+      const char *state = TEST_STATES[tc->test_result.state];
+
+      // the case spans its first phase through the end of result processing; forked cases
+      // go to their worker's track
+      const PhaseTiming *first = &tc->timings[PHASE_BEFORE_TEST];
+      const PhaseTiming *last = &tc->timings[PHASE_RESULT];
+      double case_ns = get_elapsed_ns(first->start, last->start) + last->ns;
+      trace_span(ctx, "case", tc->name, set, state, tc->worker, first->start, case_ns);
+      trace_span(ctx, "phase", TEST_PHASES[PHASE_SETUP], set, state, tc->worker, tc->timings[PHASE_SETUP].start, tc->timings[PHASE_SETUP].ns);
+      trace_span(ctx, "phase", TEST_PHASES[PHASE_BODY], set, state, tc->worker, tc->timings[PHASE_BODY].start, tc->timings[PHASE_BODY].ns);
+      trace_span(ctx, "phase", TEST_PHASES[PHASE_TEARDOWN], set, state, tc->worker, tc->timings[PHASE_TEARDOWN].start, tc->timings[PHASE_TEARDOWN].ns);
+   }
+}
+void trace_flush(object context)
+{
+   struct TraceHookContext *ctx = context;
+   if (ctx->flushed)
+      return;
+
+   FILE *out = ctx->path ? fopen(ctx->path, "w") : stdout;
+   if (!out)
+   {
+      fwritelnf(stderr, "Error: Failed to open trace file %s", ctx->path);
+      return;
+   }
+
+   int pid = (int)getpid();
+   fprintf(out, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+   fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, \"args\": {\"name\": \"sigtest\"}}", pid);
+   int *workers = NULL, worker_count = 0, worker_size = 0;
+   for (TraceChunk *chunk = __atomic_load_n(&published, __ATOMIC_ACQUIRE); chunk; chunk = chunk->next)
+   {
+      if (chunk->first)
+      {
+         fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"worker %d\"}}",
+                 pid, chunk->tid, chunk->tid);
+      }
+      for (int i = 0; i < chunk->used; i++)
+      {
+         TraceEvent *event = &chunk->events[i];
+         if (event->worker && worker_track(&workers, &worker_count, &worker_size, event->worker))
+         {
+            fprintf(out, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"fork worker %d\"}}",
+                    pid, event->worker, event->worker);
+         }
+         fprintf(out, ",\n{\"name\": \"");
+         write_json_str(out, event->name);
+         fprintf(out, "\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d, \"args\": {\"set\": \"",
+                 event->cat, event->ts_us, event->dur_us, pid, event->worker ? event->worker : chunk->tid);
+         write_json_str(out, event->set);
+         fprintf(out, "\"");
+         if (event->state)
+            fprintf(out, ", \"state\": \"%s\"", event->state);
+         fprintf(out, "}}");
+      }
+   }
+   fprintf(out, "\n]}\n");
+   free(workers);
+
+   if (out != stdout)
+      fclose(out);
+   else
+      fflush(out);
+   ctx->flushed = TRUE;
+}
@@ -5,7 +5,7 @@
 	David Boarman
 	2024-09-01
 */
-#include "sigtest.h"
+#include "sigtest_internal.h"
 #include <stdlib.h>
 #include <setjmp.h>
 #include <math.h>
@@ -15,12 +15,19 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 #define SIGTEST_VERSION "0.03.01"
 
 // Global test set "registry"
 TestSet test_sets = NULL;
 static TestSet current_set = NULL;
+// set when running one order of a shuffled-order hunt: set logs and hooks write nowhere
+static int null_output = FALSE;
 
 // Static buffer for jump
 static jmp_buf jmpbuffer;
@@ -36,6 +43,19 @@ const char *TEST_STATES[] = {
 	 "PASS",
 	 "FAIL",
 	 "SKIP",
+	 "TIMEOUT",
+	 "CRASH",
+	 "NOT_RUN",
+	 NULL,
+};
+// For dynamic test phase annotation
+const char *TEST_PHASES[] = {
+	 "before_test",
+	 "setup",
+	 "body",
+	 "teardown",
+	 "after_test",
+	 "result",
 	 NULL,
 };
 // For dynamic log level annotation
@@ -58,12 +78,44 @@ double get_elapsed_ms(ts_time *start, ts_time *end)
 {
 	return ((double)(end->tv_sec - start->tv_sec) * 1000.0) + ((double)(end->tv_nsec - start->tv_nsec) / 1000000.0);
 }
+//	timeout expiry, called from the watchdog's signal handler: back to the runner
+static void expire_test(void)
+{
+	longjmp(jmpbuffer, 2);
+}
+//	contained crash, called from the crash guard's signal handler: back to the runner
+static void crash_test(void)
+{
+	longjmp(jmpbuffer, 3);
+}
+//	record a phase that began at `start`; returns the closing tick so phases can be chained
+static ts_tick end_phase(PhaseTiming *phase, ts_tick start)
+{
+	ts_tick now = sys_getticks();
+	phase->start = start;
+	phase->ns = get_elapsed_ns(start, now);
+
+	return now;
+}
 //	internal logger declarations
 static void log_message(const char *, ...);
 static void log_debug(DebugLevel, const char *, ...);
 // hooks registry
 static HookRegistry *hook_registry = NULL;
 
+// Registry index: `set/case` ids to their cases, open addressing, built at registration
+typedef struct
+{
+	unsigned int hash;
+	TestSet set;
+	TestCase tc; /* NULL for an empty slot */
+} IndexSlot;
+static IndexSlot *index_slots = NULL;
+static int index_size = 0; /* Slots; a power of two */
+static int index_used = 0;
+static int duplicate_ids = 0; /* Cases registered under an id already taken */
+static void index_case(TestSet, TestCase);
+
 //	Implementations for internal helpers
 /**
  * Formats the current time into a buffer using the specified format
@@ -73,6 +125,21 @@ void get_timestamp(char *buffer, const char *format)
 	time_t now = time(NULL);
 	strftime(buffer, 32, format, localtime(&now));
 }
+/**
+ * Hashes a test's stable id: its set and case names
+ */
+unsigned int test_id_hash(const char *set, const char *name)
+{
+	// FNV-1a over both names, separated so ("ab","c") and ("a","bc") differ
+	unsigned int hash = 2166136261u;
+	for (const char *s = set; *s; s++)
+		hash = (hash ^ (unsigned char)*s) * 16777619u;
+	hash = (hash ^ 0x1f) * 16777619u;
+	for (const char *s = name; *s; s++)
+		hash = (hash ^ (unsigned char)*s) * 16777619u;
+
+	return hash;
+}
 // format write message to stream
 void fwritef(FILE *, const char *, ...);
 // Initialize hooks with the given name/label
@@ -116,6 +183,8 @@ SigtestHooks init_hooks(const char *name)
 		 .on_end_test = NULL,
 		 .on_error = NULL,
 		 .on_test_result = NULL,
+		 .on_results_batch = NULL,
+		 .batch_size = 0,
 		 .context = NULL,
 	};
 
@@ -131,17 +200,22 @@ static void cleanup_test_runner(void)
 	while (set)
 	{
 		TestSet next = set->next;
-		// free test cases
-		TestCase tc = set->cases;
-		while (tc)
+		// free test cases, run or filtered out
+		TestCase lists[] = {set->cases, set->filtered};
+		for (int list = 0; list < 2; list++)
 		{
-			TestCase next_tc = tc->next;
-			free(tc->name);
-			if (tc->test_result.message)
-				free(tc->test_result.message);
-
-			free(tc);
-			tc = next_tc;
+			TestCase tc = lists[list];
+			while (tc)
+			{
+				TestCase next_tc = tc->next;
+				free(tc->name);
+				if (tc->test_result.message)
+					free(tc->test_result.message);
+				free(tc->repeat);
+
+				free(tc);
+				tc = next_tc;
+			}
 		}
 
 		// free test set
@@ -158,6 +232,10 @@ static void cleanup_test_runner(void)
 	if (current_set && current_set->logger)
 		free(current_set->logger);
 
+	free(index_slots);
+	index_slots = NULL;
+	index_size = index_used = duplicate_ids = 0;
+
 	// Reset the test set registry
 	test_sets = NULL;
 	current_set = NULL;
@@ -627,17 +705,27 @@ void testset(string name, ConfigFunc config, CleanupFunc cleanup)
 		exit(EXIT_FAILURE);
 	}
 	set->name = strdup(name);
+	set->config = config;
 	set->cleanup = cleanup;
 	set->setup = NULL;
 	set->teardown = NULL;
 	set->log_stream = stdout;
 	set->cases = NULL;
 	set->tail = NULL;
+	set->filtered = NULL;
 	set->count = 0;
 	set->passed = 0;
 	set->failed = 0;
 	set->skipped = 0;
 	set->current = NULL;
+	set->hooks = NULL;
+	set->config_time = (PhaseTiming){0, 0.0};
+	set->cleanup_time = (PhaseTiming){0, 0.0};
+	set->timeout_ms = 0.0;
+	set->fork_batch = 0;
+	set->not_run = 0;
+	set->quarantined = 0;
+	set->tags = 0;
 	set->next = test_sets;
 	set->logger = malloc(sizeof(struct sigtest_logger_s));
 	if (!set->logger)
@@ -647,26 +735,12 @@ void testset(string name, ConfigFunc config, CleanupFunc cleanup)
 		exit(EXIT_FAILURE);
 	}
 
-	// Execute config immediately if provided
-	if (config)
-	{
-		char timestamp[32];
-		get_timestamp(timestamp, "%Y-%m-%d  %H:%M:%S");
-		writelnf("[%s]   Test Set: %30s", timestamp, name);
-
-		config(&set->log_stream);
-		if (!set->log_stream)
-		{
-			set->log_stream = stdout; // Fallback to stdout if config fails
-		}
-		set->logger->log = log_message;
-		set->logger->debug = log_debug;
-	}
-	// Handle allocation failure after config
+	set->logger->log = log_message;
+	set->logger->debug = log_debug;
+	// config is deferred until the set runs
 	if (!set->name)
 	{
-		if (set->log_stream != stdout && set->log_stream)
-			fclose(set->log_stream);
+		free(set->logger);
 		free(set);
 		writelnf("Failed to allocate memory for test set name\n");
 		exit(EXIT_FAILURE);
@@ -675,6 +749,95 @@ void testset(string name, ConfigFunc config, CleanupFunc cleanup)
 	test_sets = set;
 	current_set = set;
 }
+//	find an id's slot: the case registered under it, or the empty slot it would take
+static IndexSlot *index_slot(unsigned int hash, const char *set, const char *name)
+{
+	for (int at = hash & (index_size - 1);; at = (at + 1) & (index_size - 1))
+	{
+		IndexSlot *slot = &index_slots[at];
+		if (!slot->tc || (slot->hash == hash && strcmp(slot->tc->name, name) == 0 && strcmp(slot->set->name, set) == 0))
+			return slot;
+	}
+}
+//	add a registered case to the index; an id registered twice is kept once and reported
+static void index_case(TestSet set, TestCase tc)
+{
+	tc->id_hash = test_id_hash(set->name, tc->name);
+	if ((index_used + 1) * 2 > index_size)
+	{
+		// grow at half full so probes stay short
+		IndexSlot *old = index_slots;
+		int old_size = index_size;
+		index_size = index_size ? index_size * 2 : 256;
+		index_slots = calloc(index_size, sizeof(IndexSlot));
+		if (!index_slots)
+		{
+			writelnf("Failed to allocate memory for the test index\n");
+			exit(EXIT_FAILURE);
+		}
+		for (int i = 0; i < old_size; i++)
+		{
+			if (old[i].tc)
+				*index_slot(old[i].hash, old[i].set->name, old[i].tc->name) = old[i];
+		}
+		free(old);
+	}
+
+	IndexSlot *slot = index_slot(tc->id_hash, set->name, tc->name);
+	if (slot->tc)
+	{
+		fwritelnf(stderr, "Warning: Duplicate test id '%s/%s'; results and history cannot tell the cases apart",
+					 set->name, tc->name);
+		duplicate_ids++;
+		return;
+	}
+	slot->hash = tc->id_hash;
+	slot->set = set;
+	slot->tc = tc;
+	index_used++;
+}
+/*
+	Look up a registered test case by its set and case names
+*/
+TestCase find_testcase(const char *set, const char *name, TestSet *owner)
+{
+	if (!index_size)
+		return NULL;
+
+	IndexSlot *slot = index_slot(test_id_hash(set, name), set, name);
+	if (owner)
+		*owner = slot->set;
+
+	return slot->tc;
+}
+/*
+	Run a set's config, once, just before the set runs
+*/
+static void configure_set(TestSet set)
+{
+	ConfigFunc config = set->config;
+	if (!config)
+		return;
+
+	set->config = NULL;
+	char timestamp[32];
+	get_timestamp(timestamp, "%Y-%m-%d  %H:%M:%S");
+	writelnf("[%s]   Test Set: %30s", timestamp, set->name);
+
+	ts_tick config_start = sys_getticks();
+	config(&set->log_stream);
+	end_phase(&set->config_time, config_start);
+	if (null_output && set->log_stream && set->log_stream != stdout && set->log_stream != stderr)
+	{
+		// the config still runs for its fixtures; the log it opened is shared with the other orders
+		fclose(set->log_stream);
+		set->log_stream = NULL;
+	}
+	if (!set->log_stream)
+	{
+		set->log_stream = stdout; // Fallback to stdout if config fails
+	}
+}
 /*
 	Register test to test registry
 */
@@ -704,6 +867,13 @@ void testcase(string name, TestFunc func)
 	tc->expect_throw = FALSE;
 	tc->test_result.state = PASS;
 	tc->test_result.message = NULL;
+	tc->timeout_ms = 0.0;
+	tc->worker = 0;
+	tc->tags = current_set->tags;
+	tc->repeat = NULL;
+	tc->flip_rate = -1.0;
+	tc->quarantined = FALSE;
+	tc->attempts = 0;
 	tc->next = NULL;
 
 	if (!current_set->cases)
@@ -718,6 +888,7 @@ void testcase(string name, TestFunc func)
 	}
 
 	current_set->count++;
+	index_case(current_set, tc);
 }
 /*
 	Register test to test registry with expectation to fail
@@ -748,6 +919,13 @@ void fail_testcase(string name, void (*func)(void))
 	tc->expect_throw = FALSE;
 	tc->test_result.state = PASS; // Set to PASS initially, evaluated in main
 	tc->test_result.message = NULL;
+	tc->timeout_ms = 0.0;
+	tc->worker = 0;
+	tc->tags = current_set->tags;
+	tc->repeat = NULL;
+	tc->flip_rate = -1.0;
+	tc->quarantined = FALSE;
+	tc->attempts = 0;
 	tc->next = NULL;
 
 	if (!current_set->cases)
@@ -762,6 +940,7 @@ void fail_testcase(string name, void (*func)(void))
 	}
 
 	current_set->count++;
+	index_case(current_set, tc);
 }
 /*
 	Register test to test registry with expectation to throw
@@ -792,6 +971,13 @@ void testcase_throws(string name, void (*func)(void))
 	tc->expect_throw = TRUE;
 	tc->test_result.state = PASS; // Set to PASS initially, evaluated in main
 	tc->test_result.message = NULL;
+	tc->timeout_ms = 0.0;
+	tc->worker = 0;
+	tc->tags = current_set->tags;
+	tc->repeat = NULL;
+	tc->flip_rate = -1.0;
+	tc->quarantined = FALSE;
+	tc->attempts = 0;
 	tc->next = NULL;
 
 	if (!current_set->cases)
@@ -806,6 +992,7 @@ void testcase_throws(string name, void (*func)(void))
 	}
 
 	current_set->count++;
+	index_case(current_set, tc);
 }
 /*
 	Setup test case
@@ -827,6 +1014,61 @@ void teardown_testcase(CaseOp teardown)
 		current_set->teardown = teardown;
 	}
 }
+/*
+	Register test with tags
+*/
+void testcase_tagged(string name, void (*func)(void), const char *tags)
+{
+	testcase(name, func);
+	tag_testcase(tags);
+}
+/*
+	Tag the last registered test case; tag_testset tags every case of the current set
+*/
+void tag_testcase(const char *tags)
+{
+	if (current_set && current_set->tail)
+	{
+		current_set->tail->tags |= tag_mask(tags);
+	}
+}
+void tag_testset(const char *tags)
+{
+	if (current_set)
+	{
+		TagMask mask = tag_mask(tags);
+		current_set->tags |= mask;
+		for (TestCase tc = current_set->cases; tc; tc = tc->next)
+			tc->tags |= mask;
+	}
+}
+/*
+	Set test case and test set timeouts
+*/
+void timeout_testcase(double ms)
+{
+	if (current_set && current_set->tail)
+	{
+		current_set->tail->timeout_ms = ms > 0.0 ? ms : 0.0;
+	}
+}
+void timeout_testset(double ms)
+{
+	if (current_set)
+	{
+		current_set->timeout_ms = ms > 0.0 ? ms : 0.0;
+	}
+}
+/*
+	Run the current test set's cases in fork workers
+*/
+void isolate_testset(int cases_per_child)
+{
+	if (current_set)
+	{
+		current_set->fork_batch = cases_per_child > 0 ? cases_per_child : 0;
+	}
+}
 /*
 	Register test hooks
 */
@@ -849,36 +1091,224 @@ void register_hooks(SigtestHooks hooks)
 	}
 }
 
-//	default test hooks
-static void default_before_test(object context)
+//	fan-out (composite) hooks
+typedef struct fanout_member_s
+{
+	SigtestHooks hooks;				 /* Member hooks */
+	FILE *stream;						 /* Member output stream; NULL uses the set log stream */
+	struct fanout_member_s *next; /* Next member */
+} FanoutMember;
+typedef struct
+{
+	FanoutMember *members;
+	FanoutMember *tail;
+} FanoutContext;
+//	route the set log stream to the member stream; returns the stream to restore
+static FILE *fanout_route(TestSet set, FanoutMember *member)
+{
+	if (!set)
+		return NULL;
+
+	FILE *saved = set->log_stream;
+	if (member->stream)
+		set->log_stream = member->stream;
+
+	return saved;
+}
+static void fanout_restore(TestSet set, FILE *saved)
+{
+	if (set)
+		set->log_stream = saved;
+}
+static void fanout_before_set(const TestSet set, object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->before_set)
+			continue;
+		FILE *saved = fanout_route(set, m);
+		m->hooks->before_set(set, m->hooks->context);
+		fanout_restore(set, saved);
+	}
+}
+static void fanout_after_set(const TestSet set, object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->after_set)
+			continue;
+		FILE *saved = fanout_route(set, m);
+		m->hooks->after_set(set, m->hooks->context);
+		fanout_restore(set, saved);
+	}
+}
+static void fanout_before_test(object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->before_test)
+			continue;
+		FILE *saved = fanout_route(current_set, m);
+		m->hooks->before_test(m->hooks->context);
+		fanout_restore(current_set, saved);
+	}
+}
+static void fanout_after_test(object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->after_test)
+			continue;
+		FILE *saved = fanout_route(current_set, m);
+		m->hooks->after_test(m->hooks->context);
+		fanout_restore(current_set, saved);
+	}
+}
+static void fanout_on_start_test(object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->on_start_test)
+			continue;
+		FILE *saved = fanout_route(current_set, m);
+		m->hooks->on_start_test(m->hooks->context);
+		fanout_restore(current_set, saved);
+	}
+}
+static void fanout_on_end_test(object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->on_end_test)
+			continue;
+		FILE *saved = fanout_route(current_set, m);
+		m->hooks->on_end_test(m->hooks->context);
+		fanout_restore(current_set, saved);
+	}
+}
+static void fanout_on_error(const char *message, object context)
 {
-	struct
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
 	{
-		int count;
-		int verbose;
-		ts_time start;
-		ts_time end;
-	} *ctx = context;
+		if (!m->hooks->on_error)
+			continue;
+		FILE *saved = fanout_route(current_set, m);
+		m->hooks->on_error(message, m->hooks->context);
+		fanout_restore(current_set, saved);
+	}
+}
+static void fanout_on_test_result(const TestSet set, const TestCase tc, object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->on_test_result)
+			continue;
+		FILE *saved = fanout_route(set, m);
+		m->hooks->on_test_result(set, tc, m->hooks->context);
+		fanout_restore(set, saved);
+	}
+}
+static void fanout_on_results_batch(const TestSet set, const TestCase *cases, int count, object context)
+{
+	for (FanoutMember *m = ((FanoutContext *)context)->members; m; m = m->next)
+	{
+		if (!m->hooks->on_results_batch)
+			continue;
+		FILE *saved = fanout_route(set, m);
+		m->hooks->on_results_batch(set, cases, count, m->hooks->context);
+		fanout_restore(set, saved);
+	}
+}
+/*
+	Create fan-out hooks
+*/
+SigtestHooks init_fanout_hooks(const char *name)
+{
+	if (!name || !*name)
+	{
+		fwritelnf(stderr, "Error: Hook name cannot be NULL or empty");
+		return NULL; // Invalid name
+	}
+	SigtestHooks hooks = malloc(sizeof(struct sigtest_hooks_s));
+	FanoutContext *ctx = calloc(1, sizeof(FanoutContext));
+	if (!hooks || !ctx)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate memory for fan-out hooks");
+		free(hooks);
+		free(ctx);
+		return NULL; // Memory allocation failed
+	}
+	*hooks = (struct sigtest_hooks_s){
+		 .name = strdup(name),
+		 .before_set = fanout_before_set,
+		 .after_set = fanout_after_set,
+		 .before_test = fanout_before_test,
+		 .after_test = fanout_after_test,
+		 .on_start_test = fanout_on_start_test,
+		 .on_end_test = fanout_on_end_test,
+		 .on_error = fanout_on_error,
+		 .on_test_result = fanout_on_test_result,
+		 .on_results_batch = NULL,
+		 .batch_size = 0,
+		 .context = ctx,
+	};
 
-	ctx->count++;
+	return hooks;
 }
-static void default_on_start_test(object context)
+/*
+	Add member hooks to fan-out hooks
+*/
+int fanout_add_hooks(SigtestHooks fanout, SigtestHooks hooks, FILE *stream)
 {
-	struct
+	if (!fanout || !hooks || fanout->before_set != fanout_before_set)
+	{
+		fwritelnf(stderr, "Error: Invalid fan-out hooks or member hooks");
+		return -1;
+	}
+	FanoutMember *member = malloc(sizeof(FanoutMember));
+	if (!member)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate fan-out hooks member");
+		return -1;
+	}
+	member->hooks = hooks;
+	member->stream = stream;
+	member->next = NULL;
+	// batch delivery is enabled once any member asks for it
+	if (hooks->on_results_batch)
 	{
-		int count;
-		int verbose;
-		ts_time start;
-		ts_time end;
-	} *ctx = context;
+		fanout->on_results_batch = fanout_on_results_batch;
+	}
 
-	if (sys_gettime(&ctx->start) == -1)
+	FanoutContext *ctx = fanout->context;
+	if (!ctx->members)
 	{
-		fwritelnf(stderr, "Error: Failed to get system start time");
-		exit(EXIT_FAILURE);
+		ctx->members = member;
+	}
+	else
+	{
+		ctx->tail->next = member;
 	}
-	// zero out the end time
-	ctx->end = (ts_time){0, 0};
+	ctx->tail = member;
+
+	return 0;
+}
+
+//	default test hooks
+typedef struct
+{
+	int count;
+	int verbose;
+} DefaultHookContext;
+static void default_before_test(object context)
+{
+	DefaultHookContext *ctx = context;
+
+	ctx->count++;
+}
+static void default_on_start_test(object context)
+{
+	DefaultHookContext *ctx = context;
 
 	if (ctx->verbose && current_set)
 	{
@@ -887,19 +1317,8 @@ static void default_on_start_test(object context)
 }
 static void default_on_end_test(object context)
 {
-	struct
-	{
-		int count;
-		int verbose;
-		ts_time start;
-		ts_time end;
-	} *ctx = context;
+	DefaultHookContext *ctx = context;
 
-	if (sys_gettime(&ctx->end) == -1)
-	{
-		fwritelnf(stderr, "Error: Failed to get system end time");
-		exit(EXIT_FAILURE);
-	}
 	if (ctx->verbose && current_set)
 	{
 		current_set->logger->log("Finished test: %s\n", current_set->current->name);
@@ -907,48 +1326,41 @@ static void default_on_end_test(object context)
 }
 static void default_after_test(object context)
 {
-	struct
-	{
-		int count;
-		int verbose;
-		ts_time start;
-		ts_time end;
-	} *ctx = context;
+	DefaultHookContext *ctx = context;
 
 	ctx->count--;
 }
 static void default_on_test_result(const TestSet set, const TestCase tc, object context)
 {
-	struct
-	{
-		int count;
-		int verbose;
-		ts_time start;
-		ts_time end;
-	} *ctx = context;
+	DefaultHookContext *ctx = context;
 
 	const char *status = TEST_STATES[tc->test_result.state];
-	//	if we have a zero end time, we need to set it
-	if (ctx->end.tv_sec == 0 && ctx->end.tv_nsec == 0)
+	// the runner times the test body; the clock resolves well below a microsecond
+	double elapsed_ns = tc->timings[PHASE_BODY].ns;
+	set->logger->log("Running: %-37s  %6.3f us  [%s]\n", tc->name, elapsed_ns / 1000.0, status);
+	if (tc->quarantined)
 	{
-		if (sys_gettime(&ctx->end) == -1)
+		set->logger->log("\tquarantined: flip rate %.2f\n", tc->flip_rate);
+	}
+	// a repeated case stands for all its runs; its body time is their mean
+	if (tc->repeat)
+	{
+		RepeatStats *stats = tc->repeat;
+		set->logger->log("\truns= %llu  failures= %llu  min/p50/p99/max= %.3f/%.3f/%.3f/%.3f us\n", stats->runs,
+							  stats->failures, stats->min_ns / 1000.0, repeat_percentile(stats, 0.5) / 1000.0,
+							  repeat_percentile(stats, 0.99) / 1000.0, stats->max_ns / 1000.0);
+		for (int bucket = 0; ctx->verbose && bucket < REPEAT_BUCKETS; bucket++)
 		{
-			fwritelnf(stderr, "Error: Failed to get system end time");
-			exit(EXIT_FAILURE);
+			if (stats->histogram[bucket])
+				set->logger->debug(DBG_DEBUG, "\t< %12.3f us %10llu\n", (1ULL << bucket) / 1000.0, stats->histogram[bucket]);
 		}
 	}
-	// calculate elapsed time
-	double elapsed_ms = get_elapsed_ms(&ctx->start, &ctx->end);
-	// Log duration: show "< 0.0001 ms" if negative or too small
-	if (elapsed_ms < 0.0001)
-	{
-		set->logger->log("Running: %-36s  < 0.1 us  [%s]\n", tc->name, status);
-	}
-	else
+
+	// a timeout or crash report is useless without its reason
+	if (!ctx->verbose && tc->test_result.message && (tc->test_result.state == TIMEOUT || tc->test_result.state == CRASH))
 	{
-		set->logger->log("Running: %-37s  %6.3f us  [%s]\n", tc->name, elapsed_ms * 1000.0, status);
+		set->logger->log("\t%s\n", tc->test_result.message);
 	}
-
 	if (ctx->verbose && tc->test_result.message)
 	{
 		DebugLevel level = (tc->test_result.state == PASS) ? DBG_INFO : DBG_DEBUG;
@@ -956,19 +1368,17 @@ static void default_on_test_result(const TestSet set, const TestCase tc, object
 	}
 	if (ctx->verbose)
 	{
-		set->logger->debug(DBG_DEBUG, "\tstart= %ld.%04ld", ctx->start.tv_sec, ctx->start.tv_nsec);
-		set->logger->log("\tend=   %ld.%04ld\n", ctx->end.tv_sec, ctx->end.tv_nsec);
+		// the result phase is still running; every earlier phase is final
+		for (int phase = PHASE_BEFORE_TEST; phase < PHASE_RESULT; phase++)
+		{
+			set->logger->debug(DBG_DEBUG, "\t%-12s %10.3f us\n", TEST_PHASES[phase], tc->timings[phase].ns / 1000.0);
+		}
+		set->logger->log("\tclock= %s\n", sys_clock_source());
 	}
 }
 static void default_on_error(const char *message, object context)
 {
-	struct
-	{
-		int count;
-		int verbose;
-		ts_time start;
-		ts_time end;
-	} *ctx = context;
+	DefaultHookContext *ctx = context;
 
 	if (ctx->verbose && current_set)
 	{
@@ -976,13 +1386,7 @@ static void default_on_error(const char *message, object context)
 	}
 }
 
-static struct
-{
-	int count;
-	int verbose;
-	ts_time start;
-	ts_time end;
-} default_ctx = {0, 0, {0, 0}, {0, 0}};
+static DefaultHookContext default_ctx = {0, 0};
 static const sigtest_hooks_s default_hooks = {
 	 .name = "default",
 	 .before_set = NULL,
@@ -993,9 +1397,11 @@ static const sigtest_hooks_s default_hooks = {
 	 .after_test = default_after_test,
 	 .on_error = default_on_error,
 	 .on_test_result = default_on_test_result,
+	 .on_results_batch = NULL,
+	 .batch_size = 0,
 	 .context = &default_ctx};
-//	 initialize on start up
-__attribute__((constructor)) static void init_default_hooks(void)
+//	 initialize on start up, ahead of test registration constructors
+__attribute__((constructor(101))) static void init_default_hooks(void)
 {
 	HookRegistry *entry = malloc(sizeof(HookRegistry));
 	// if we don't have a valid hooks registry, we exit
@@ -1010,71 +1416,1759 @@ __attribute__((constructor)) static void init_default_hooks(void)
 	hook_registry = entry;
 }
 
-#ifdef SIGTEST_TEST
-/*
-	test executor entry point
-*/
-int main(void)
+//	runner options: command line flags and the environment variables run_tests reads
+#define OPTION_OPTIONAL 2
+//	option values a flag must have; run_tests would read a malformed number as 0
+#define VALUE_TEXT 0
+#define VALUE_COUNT 1	  /* A whole number up to INT_MAX */
+#define VALUE_WORKERS 2  /* A whole number up to OPTION_WORKERS_MAX */
+#define VALUE_NUMBER 3	  /* A number of at least 0 */
+#define VALUE_DURATION 4 /* A number with an optional ms, s, m or h unit */
+#define VALUE_SEED 5	  /* A 64-bit whole number */
+#define OPTION_WORKERS_MAX 4096
+static const char *VALUE_EXPECTED[] = {
+	 "",
+	 "a whole number",
+	 "a whole number from 0 to 4096",
+	 "a number of at least 0",
+	 "a duration such as 500ms, 90s or 2m",
+	 "a whole number",
+};
+static const struct
 {
-	int retResult = run_tests(test_sets, NULL);
-	cleanup_test_runner();
+	const char *flag;
+	const char *env;
+	int takes_value; /* TRUE: `--flag=value`; FALSE: a bare switch; OPTION_OPTIONAL: either */
+	int value;		  /* VALUE_*: what a given value must be */
+	const char *word; /* Taken besides a number, and set by a bare OPTION_OPTIONAL flag; NULL sets "1" */
+} RUN_OPTIONS[] = {
+	 {"--timeout", "SIGTEST_TIMEOUT_MS", TRUE, VALUE_NUMBER, NULL},
+	 {"--crash-guard", "SIGTEST_CRASH_GUARD", TRUE, VALUE_TEXT, NULL},
+	 {"--profile", "SIGTEST_PROFILE", TRUE, VALUE_TEXT, NULL},
+	 {"--workers", "SIGTEST_WORKERS", TRUE, VALUE_WORKERS, "auto"},
+	 {"--fork", "SIGTEST_FORK", TRUE, VALUE_WORKERS, NULL},
+	 {"--journal", "SIGTEST_JOURNAL", TRUE, VALUE_TEXT, NULL},
+	 {"--resume", "SIGTEST_RESUME", FALSE, VALUE_TEXT, NULL},
+	 {"--max-failures", "SIGTEST_MAX_FAILURES", TRUE, VALUE_COUNT, NULL},
+	 {"--history", "SIGTEST_HISTORY", TRUE, VALUE_TEXT, NULL},
+	 {"--order", "SIGTEST_ORDER", TRUE, VALUE_TEXT, NULL},
+	 {"--filter", "SIGTEST_FILTER", TRUE, VALUE_TEXT, NULL},
+	 {"--tags", "SIGTEST_TAGS", TRUE, VALUE_TEXT, NULL},
+	 {"--list", "SIGTEST_LIST", OPTION_OPTIONAL, VALUE_TEXT, NULL},
+	 {"--manifest", "SIGTEST_MANIFEST", TRUE, VALUE_TEXT, NULL},
+	 {"--duplicates", "SIGTEST_DUPLICATES", TRUE, VALUE_TEXT, NULL},
+	 {"--repeat", "SIGTEST_REPEAT", TRUE, VALUE_COUNT, NULL},
+	 {"--repeat-for", "SIGTEST_REPEAT_FOR", TRUE, VALUE_DURATION, NULL},
+	 {"--until-fail", "SIGTEST_UNTIL_FAIL", FALSE, VALUE_TEXT, NULL},
+	 {"--quarantine", "SIGTEST_QUARANTINE", OPTION_OPTIONAL, VALUE_NUMBER, NULL},
+	 {"--retries", "SIGTEST_RETRIES", TRUE, VALUE_COUNT, NULL},
+	 {"--shuffle", "SIGTEST_SHUFFLE", OPTION_OPTIONAL, VALUE_SEED, "random"},
+	 {"--shuffle-orders", "SIGTEST_SHUFFLE_ORDERS", TRUE, VALUE_COUNT, NULL},
+	 {"--trend", "SIGTEST_TREND", OPTION_OPTIONAL, VALUE_TEXT, NULL},
+	 {"--slowdown", "SIGTEST_SLOWDOWN", TRUE, VALUE_NUMBER, NULL},
+	 {"--trend-top", "SIGTEST_TREND_TOP", TRUE, VALUE_COUNT, NULL},
+	 {"--max-regressions", "SIGTEST_MAX_REGRESSIONS", TRUE, VALUE_COUNT, NULL},
+	 {"--progress", "SIGTEST_PROGRESS", FALSE, VALUE_TEXT, NULL},
+	 {NULL, NULL, FALSE, VALUE_TEXT, NULL},
+};
+//	check a flag's value against what run_tests reads from it
+static int option_valid(int kind, const char *word, const char *value)
+{
+	if (kind == VALUE_TEXT || (word && strcmp(value, word) == 0))
+		return TRUE;
+	if (kind == VALUE_DURATION)
+		return repeat_duration_ms(value) >= 0.0;
 
-	return retResult;
+	char *end = NULL;
+	if (kind == VALUE_NUMBER)
+	{
+		double number = strtod(value, &end);
+		return end != value && !*end && number >= 0.0 && isfinite(number);
+	}
+	// whole numbers: digits only, so strtoull takes no sign or leading space
+	if (*value < '0' || *value > '9')
+		return FALSE;
+	errno = 0;
+	unsigned long long number = strtoull(value, &end, 10);
+	if (*end || errno == ERANGE)
+		return FALSE;
+
+	return kind == VALUE_SEED || number <= (kind == VALUE_WORKERS ? OPTION_WORKERS_MAX : INT_MAX);
 }
-#endif // SIGTEST_TEST
-
-// the actual test runner
-int run_tests(TestSet sets, SigtestHooks test_hooks)
+/*
+	Apply a runner option
+*/
+int sigtest_option(const char *arg)
 {
-	int total_tests = 0;
-	int set_sequence = 1;
-	char timestamp[32];
-
-	// Log total registered test sets for debugging
-	int total_sets = 0;
-	SigtestHooks hooks = NULL;
-	for (TestSet set = sets; set; set = set->next)
+	for (int i = 0; RUN_OPTIONS[i].flag; i++)
 	{
-		/*
-			We need to check if we have a test_hooks set; if not we need to use the default hooks.
-			If we have a set->hooks, and a test_hooks, we need to prioritize the test_hooks.
-
-			CLI options:
-			  `-s`: simple mode, no hooks will be provided by the test runner; however, the test
-					  set could register hooks and those will be used.
-				default (no flag): the test runner can provide hooks intended to override the test
-					  set hooks. If NULL is passed, then the default hooks will be used.
-		 */
-		if (!test_hooks && !set->hooks)
+		size_t length = strlen(RUN_OPTIONS[i].flag);
+		if (strncmp(arg, RUN_OPTIONS[i].flag, length) != 0 || (arg[length] && arg[length] != '='))
+			continue;
+		if (RUN_OPTIONS[i].takes_value == TRUE && (arg[length] != '=' || !arg[length + 1]))
 		{
-			//	set the default hooks
-			hooks = hook_registry->hooks;
+			fwritelnf(stderr, "Error: Option %s needs a value (%s=<value>)", RUN_OPTIONS[i].flag, RUN_OPTIONS[i].flag);
+			return -1;
 		}
-		else if (test_hooks)
+		if (!RUN_OPTIONS[i].takes_value && arg[length] == '=')
 		{
-			hooks = test_hooks;
+			fwritelnf(stderr, "Error: Option %s takes no value", RUN_OPTIONS[i].flag);
+			return -1;
 		}
-		else
+		const char *value = arg[length] == '=' ? arg + length + 1 : NULL;
+		if (value && !option_valid(RUN_OPTIONS[i].value, RUN_OPTIONS[i].word, value))
 		{
-			hooks = set->hooks;
+			fwritelnf(stderr, "Error: Invalid value %s; expected %s%s%s", arg, VALUE_EXPECTED[RUN_OPTIONS[i].value],
+						 RUN_OPTIONS[i].word ? " or " : "", RUN_OPTIONS[i].word ? RUN_OPTIONS[i].word : "");
+			return -1;
 		}
-
-		total_sets++;
+		setenv(RUN_OPTIONS[i].env, value ? value : RUN_OPTIONS[i].word ? RUN_OPTIONS[i].word : "1", 1);
+		return 1;
 	}
-	if (total_sets == 0)
+
+	return 0;
+}
+
+#ifdef SIGTEST_TEST
+/*
+	test executor entry point
+*/
+int main(int argc, char **argv)
+{
+	for (int i = 1; i < argc; i++)
 	{
-		return 0;
+		int applied = sigtest_option(argv[i]);
+		if (applied == 0)
+			fwritelnf(stderr, "Error: Unknown option: '%s'", argv[i]);
+		if (applied <= 0)
+			return EXIT_FAILURE;
 	}
 
-	for (TestSet set = sets; set; set = set->next, set_sequence++)
-	{
-		int tc_total = 0, tc_passed = 0, tc_failed = 0, tc_skipped = 0;
-		if (!set->log_stream || !set->logger)
+	int retResult = run_tests(test_sets, NULL);
+	cleanup_test_runner();
+
+	return retResult;
+}
+#endif // SIGTEST_TEST
+
+//	runner state shared by the case helpers
+typedef struct
+{
+	SigtestHooks hooks;
+	double timeout_ms;				/* Global test body timeout */
+	int crash_guard;					/* Crash containment installed */
+	int crash_quarantine;			/* Skip the rest of a set after a crash */
+	int fork_batch;					/* Global cases per fork worker; 0 keeps a worker for the set */
+	int workers;						/* Fork workers per set; 0 runs in-process unless a set isolates */
+	struct sigaction sigpipe;		/* SIGPIPE disposition while no worker pool is up */
+	const char *quarantine_cause; /* Case whose crash left the set suspect */
+	Journal *journal;					/* Completion journal; NULL when not journaling */
+	int max_failures;					/* Cancel the run after this many failures; 0 for no limit */
+	int failures;						/* Failures across the run */
+	int cancelled;						/* Failure limit reached; no further case runs */
+	int replaying;						/* Reporting a case restored from the journal */
+	History *history;					/* Result store; NULL when not recording outcomes */
+	int repeating;						/* Repeat mode: each case runs many times and is reported once */
+	unsigned long long repeat;		/* Runs per case; 0 for no limit */
+	double repeat_for_ms;			/* Time each case keeps running; 0 for no limit */
+	int until_fail;					/* Stop repeating a case at its first failure */
+	unsigned long long repeat_runs; /* Runs across the repeated cases */
+	double quarantine_rate;			/* Quarantine cases whose flip rate reaches it; 0 when off */
+	int retries;						/* Extra runs for a failing quarantined case */
+	int quarantined;					/* Quarantined failures in the set */
+	int total_quarantined;
+	Trend *trend;						/* Duration trend; NULL unless reporting one */
+	Progress *progress;				/* Live status line; NULL unless drawing one */
+	int total, passed, failed, skipped, not_run;
+	int total_tests;
+	int total_passed;
+	int total_skipped;
+	int total_not_run;
+	int batch_size;
+	int batch_count;
+	TestCase batch[SIGTEST_MAX_BATCH];
+} RunState;
+
+//	the case timeout wins over the set and global timeouts
+static double case_timeout(RunState *run, TestSet set, TestCase tc)
+{
+	return tc->timeout_ms > 0.0 ? tc->timeout_ms : set->timeout_ms > 0.0 ? set->timeout_ms
+																								  : run->timeout_ms;
+}
+static void set_result(TestCase tc, TestState state, const char *message)
+{
+	tc->test_result.state = state;
+	if (tc->test_result.message)
+		free(tc->test_result.message);
+	tc->test_result.message = message ? strdup(message) : NULL;
+}
+/*
+	Run a test case through every phase up to result processing; `guarded` arms the
+	watchdog and crash guard (forked children are guarded by their parent instead)
+*/
+static void execute_case(RunState *run, TestSet set, TestCase tc, int guarded)
+{
+	SigtestHooks hooks = run->hooks;
+	set->current = tc; // Set current test for set_test_context
+	ts_tick mark = sys_getticks();
+	//	before test case setup
+	if (hooks && hooks->before_test)
+	{
+		hooks->before_test(hooks->context);
+	}
+	mark = end_phase(&tc->timings[PHASE_BEFORE_TEST], mark);
+	//	test case setup; a quarantined set no longer touches its fixtures
+	if (set->setup && !run->quarantine_cause)
+	{
+		set->setup();
+	}
+	mark = end_phase(&tc->timings[PHASE_SETUP], mark);
+	// on start test handler
+	if (hooks && hooks->on_start_test)
+	{
+		hooks->on_start_test(hooks->context);
+	}
+	tc->timings[PHASE_BEFORE_TEST].ns += get_elapsed_ns(mark, sys_getticks());
+	//	test case execution
+	double timeout_ms = guarded ? case_timeout(run, set, tc) : 0.0;
+	if (run->quarantine_cause)
+	{
+		char message[160];
+		snprintf(message, sizeof(message), "Quarantined: `%s` crashed earlier in the set", run->quarantine_cause);
+		tc->timings[PHASE_BODY].start = sys_getticks();
+		set_result(tc, SKIP, message);
+	}
+	else
+	{
+		switch (setjmp(jmpbuffer))
+		{
+		case 0:
+			profile_enter_case(set, tc, __builtin_frame_address(0));
+			tc->timings[PHASE_BODY].start = sys_getticks();
+			timeout_arm(timeout_ms, expire_test);
+			if (guarded && run->crash_guard)
+				crash_arm(crash_test);
+			tc->test_func();
+			break;
+		case 2:
+		{
+			// the watchdog fired; the body was abandoned where it stood
+			char message[64];
+			snprintf(message, sizeof(message), "Timed out after %.0f ms", timeout_ms);
+			set_result(tc, TIMEOUT, message);
+			break;
+		}
+		case 3:
+		{
+			// the crash guard caught a fatal signal in the body
+			char message[512];
+			crash_describe(message, sizeof(message));
+			set_result(tc, CRASH, message);
+			if (run->crash_quarantine)
+				run->quarantine_cause = tc->name;
+			break;
+		}
+		default:
+			// Longjmp triggered by an assertion failure (FAIL, SKIP, etc.)
+			/*
+				We can add a custom handler for `on_exception`, `on_fail`, `on_skip`
+			 */
+			break;
+		}
+	}
+	timeout_disarm();
+	crash_disarm();
+	mark = end_phase(&tc->timings[PHASE_BODY], tc->timings[PHASE_BODY].start);
+	profile_leave_case(tc->timings[PHASE_BODY].ns);
+	// on end test handler
+	if (hooks && hooks->on_end_test)
+	{
+		hooks->on_end_test(hooks->context);
+	}
+	ts_tick end_test = sys_getticks();
+	double end_test_ns = get_elapsed_ns(mark, end_test);
+	//	test case teardown
+	if (set->teardown && !run->quarantine_cause)
+	{
+		set->logger->log("Running teardown");
+		set->teardown();
+	}
+	mark = end_phase(&tc->timings[PHASE_TEARDOWN], end_test);
+	//	after test case teardown
+	if (hooks && hooks->after_test)
+	{
+		hooks->after_test(hooks->context);
+	}
+	end_phase(&tc->timings[PHASE_AFTER_TEST], mark);
+	tc->timings[PHASE_AFTER_TEST].ns += end_test_ns;
+}
+//	does a run break the case's expectation
+static int run_failed(TestCase tc, TestState state)
+{
+	if (tc->expect_fail || tc->expect_throw)
+		return state != FAIL && state != SKIP;
+
+	return state == FAIL || state == TIMEOUT || state == CRASH;
+}
+//	should a failed case run again: quarantined with retries left; the failed attempt is recorded
+static int retry_case(RunState *run, TestSet set, TestCase tc)
+{
+	if (!tc->quarantined || tc->attempts > run->retries || !run_failed(tc, tc->test_result.state))
+		return FALSE;
+	if (run->history)
+		history_retry(run->history, set, tc);
+
+	return TRUE;
+}
+/*
+	Apply expectations to an executed case and hand its result to the hooks
+*/
+static void report_case(RunState *run, TestSet set, TestCase tc)
+{
+	SigtestHooks hooks = run->hooks;
+	ts_tick mark = sys_getticks();
+	// journal what the body produced; expectations are applied again on resume
+	if (run->journal && !run->replaying && tc->test_result.state != NOT_RUN)
+	{
+		journal_append(run->journal, set, tc);
+	}
+	if (tc->attempts > 1 && !run_failed(tc, tc->test_result.state))
+	{
+		char message[64];
+		snprintf(message, sizeof(message), "Passed on attempt %d; quarantined as flaky", tc->attempts);
+		set_result(tc, tc->test_result.state, message);
+	}
+	// process test result
+	if (tc->expect_fail)
+	{
+		if (tc->test_result.state == FAIL)
+		{
+			tc->test_result.state = PASS;
+			if (tc->test_result.message)
+			{
+				free(tc->test_result.message);
+				tc->test_result.message = strdup("Expected failure occurred");
+			}
+		}
+		else if (tc->test_result.state == PASS)
+		{
+			set_result(tc, FAIL, "Expected failure but passed");
+		}
+	}
+	else if (tc->expect_throw)
+	{
+		if (tc->test_result.state == FAIL)
+		{
+			tc->test_result.state = PASS;
+			if (tc->test_result.message)
+			{
+				free(tc->test_result.message);
+				tc->test_result.message = strdup("Expected throw occurred");
+			}
+		}
+		else if (tc->test_result.state == PASS)
+		{
+			set_result(tc, FAIL, "Expected throw but passed");
+		}
+	}
+	//	process test result
+	if (tc->test_result.state == PASS)
+	{
+		if (hooks && hooks->on_test_result)
+		{
+			hooks->on_test_result(set, tc, hooks->context);
+		}
+		else if (!run->batch_size)
+		{
+			set->logger->log("[PASS]\n");
+		}
+		run->passed++;
+		run->total_passed++;
+		set->passed++;
+	}
+	else if (tc->test_result.state == SKIP)
+	{
+		if (hooks && hooks->on_test_result)
+		{
+			hooks->on_test_result(set, tc, hooks->context);
+		}
+		else if (!run->batch_size)
+		{
+			set->logger->log("[SKIP]\n");
+		}
+		run->skipped++;
+		run->total_skipped++;
+		set->skipped++;
+	}
+	else if (tc->test_result.state == NOT_RUN)
+	{
+		if (hooks && hooks->on_test_result)
+		{
+			hooks->on_test_result(set, tc, hooks->context);
+		}
+		else if (!run->batch_size)
+		{
+			set->logger->log("[NOT_RUN]\n");
+		}
+		run->not_run++;
+		run->total_not_run++;
+		set->not_run++;
+	}
+	else
+	{
+		if (hooks && hooks->on_test_result)
+		{
+			hooks->on_test_result(set, tc, hooks->context);
+		}
+		else if (!run->batch_size)
+		{
+			set->logger->log("[%s]\n     %s", TEST_STATES[tc->test_result.state],
+								  tc->test_result.message ? tc->test_result.message : "Unknown");
+		}
+		// a quarantined case still reports its failure, but it does not fail the run
+		if (tc->quarantined)
+		{
+			run->quarantined++;
+			run->total_quarantined++;
+			set->quarantined++;
+		}
+		else
+		{
+			run->failed++;
+			set->failed++;
+			if (++run->failures >= run->max_failures && run->max_failures)
+				run->cancelled = TRUE;
+		}
+	}
+	if (tc->test_result.state != NOT_RUN)
+	{
+		run->total++;
+		run->total_tests++;
+	}
+	if (run->progress)
+	{
+		progress_done(run->progress, set, tc);
+	}
+	if (run->history)
+	{
+		// the trend compares with the baseline before this run joins it
+		if (run->trend)
+			trend_record(run->trend, run->history, set, tc);
+		history_record(run->history, set, tc);
+	}
+	set->current = NULL;
+	end_phase(&tc->timings[PHASE_RESULT], mark);
+
+	if (run->batch_size)
+	{
+		run->batch[run->batch_count++] = tc;
+		if (run->batch_count == run->batch_size)
+		{
+			hooks->on_results_batch(set, run->batch, run->batch_count, hooks->context);
+			run->batch_count = 0;
+		}
+	}
+}
+
+//	report a case whose body ran elsewhere (a fork worker, an earlier run): the per-case hooks, then the result
+static void report_detached_case(RunState *run, TestSet set, TestCase tc)
+{
+	SigtestHooks hooks = run->hooks;
+	set->current = tc;
+	if (hooks)
+	{
+		if (hooks->before_test)
+			hooks->before_test(hooks->context);
+		if (hooks->on_start_test)
+			hooks->on_start_test(hooks->context);
+		if (hooks->on_end_test)
+			hooks->on_end_test(hooks->context);
+		if (hooks->after_test)
+			hooks->after_test(hooks->context);
+	}
+	report_case(run, set, tc);
+}
+//	report a case the journal says an earlier run completed; returns TRUE when it did
+static int run_resumed(RunState *run, TestSet set, TestCase tc)
+{
+	if (!run->journal || !journal_restore(run->journal, set, tc))
+		return FALSE;
+
+	run->replaying = TRUE;
+	report_detached_case(run, set, tc);
+	run->replaying = FALSE;
+
+	return TRUE;
+}
+//	report a case the run was cancelled ahead of
+static void report_not_run(RunState *run, TestSet set, TestCase tc)
+{
+	char message[64];
+	snprintf(message, sizeof(message), "Not run: the run stopped after %d failures", run->failures);
+	set_result(tc, NOT_RUN, message);
+	memset(tc->timings, 0, sizeof(tc->timings));
+	tc->worker = 0;
+	report_case(run, set, tc);
+}
+//	count the cases of a set the run was cancelled ahead of; the set is never configured, so
+//	neither its cleanup nor a hook runs and nothing is written to its log
+static void skip_cancelled_set(RunState *run, TestSet set)
+{
+	char message[64];
+	snprintf(message, sizeof(message), "Not run: the run stopped after %d failures", run->failures);
+	for (TestCase tc = set->cases; tc; tc = tc->next)
+	{
+		set_result(tc, NOT_RUN, message);
+		memset(tc->timings, 0, sizeof(tc->timings));
+		tc->worker = 0;
+		run->total_not_run++;
+		set->not_run++;
+		if (run->progress)
+			progress_done(run->progress, set, tc);
+	}
+}
+//	run a case in the runner's own process and report it
+static void run_in_process(RunState *run, TestSet set, TestCase tc)
+{
+	// past the failure limit nothing runs, but every case is still reported
+	if (run->cancelled)
+	{
+		report_not_run(run, set, tc);
+		return;
+	}
+	// a quarantined failure may run again, up to SIGTEST_RETRIES more times
+	tc->attempts = 0;
+	do
+	{
+		tc->attempts++;
+		set_result(tc, PASS, NULL);
+		execute_case(run, set, tc, TRUE);
+	} while (retry_case(run, set, tc));
+	report_case(run, set, tc);
+}
+
+/*
+	Fork server: a pool of workers forked from the configured set image. The parent queues
+	case indices to each worker over a pipe; the worker publishes each result in its shared
+	result ring and rings a one-byte doorbell. Workers are recycled after a number of cases,
+	and replaced when they crash or overrun.
+*/
+#define FORK_QUEUE_DEPTH 4 /* Cases queued ahead per worker; at most RESULT_RING_SLOTS */
+typedef struct
+{
+	pid_t pid;			/* 0 when the slot is empty */
+	int requests;		/* Case indices to the worker */
+	int doorbell;		/* A byte per published result; EOF once the worker is gone */
+	ResultRing *ring; /* Results from the worker */
+	int served;			/* Cases handed to this worker */
+	int queued;			/* Cases handed over and not yet reported */
+	int queue[FORK_QUEUE_DEPTH]; /* Oldest first; the worker runs them in order */
+} ForkWorker;
+
+static int read_full(int fd, void *buffer, size_t size)
+{
+	for (size_t got = 0; got < size;)
+	{
+		ssize_t n = read(fd, (char *)buffer + got, size - got);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		got += (size_t)n;
+	}
+
+	return 0;
+}
+static int write_full(int fd, const void *buffer, size_t size)
+{
+	for (size_t done = 0; done < size;)
+	{
+		ssize_t n = write(fd, (const char *)buffer + done, size - done);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		done += (size_t)n;
+	}
+
+	return 0;
+}
+//	worker loop: run the requested cases until the parent hangs up or the worker is spent
+static void fork_worker_main(RunState *run, TestSet set, TestCase *cases, ResultRing *ring, int requests, int doorbell, int recycle)
+{
+	// per-case hooks run in the parent, where their state survives the worker
+	run->hooks = NULL;
+	sigaction(SIGPIPE, &run->sigpipe, NULL);
+	char bell = 0;
+	for (int served = 0; !recycle || served < recycle; served++)
+	{
+		int index;
+		if (read_full(requests, &index, sizeof(index)) != 0)
+			break;
+		TestCase tc = cases[index];
+		ResultSlot *slot = ring_open(ring, index);
+		if (!slot)
+			break;
+		// the parent only needs to hear about a start when it has a deadline to keep
+		if (case_timeout(run, set, tc) > 0.0 && write_full(doorbell, &bell, 1) != 0)
+			break;
+		execute_case(run, set, tc, FALSE);
+		ring_commit(slot, tc);
+		if (write_full(doorbell, &bell, 1) != 0)
+			break;
+	}
+	fflush(NULL);
+	// skip atexit handlers; they belong to the parent
+	_exit(EXIT_SUCCESS);
+}
+static int fork_worker_spawn(RunState *run, TestSet set, TestCase *cases, ForkWorker *pool, int slot, int workers, int recycle)
+{
+	int requests[2], doorbell[2];
+	if (pipe(requests) != 0)
+	{
+		fwritelnf(stderr, "Error: Failed to create worker pipe: %s", strerror(errno));
+		return -1;
+	}
+	if (pipe(doorbell) != 0)
+	{
+		fwritelnf(stderr, "Error: Failed to create worker pipe: %s", strerror(errno));
+		close(requests[0]);
+		close(requests[1]);
+		return -1;
+	}
+	ForkWorker *worker = &pool[slot];
+	ring_reset(worker->ring);
+	// anything still buffered would otherwise be written twice
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		fwritelnf(stderr, "Error: Failed to fork worker: %s", strerror(errno));
+		close(requests[0]);
+		close(requests[1]);
+		close(doorbell[0]);
+		close(doorbell[1]);
+		return -1;
+	}
+	if (pid == 0)
+	{
+		// a sibling's pipes held open here would hide its hang-up
+		for (int i = 0; i < workers; i++)
+		{
+			if (pool[i].pid)
+			{
+				close(pool[i].requests);
+				close(pool[i].doorbell);
+			}
+		}
+		close(requests[1]);
+		close(doorbell[0]);
+		fork_worker_main(run, set, cases, worker->ring, requests[0], doorbell[1], recycle);
+	}
+	close(requests[0]);
+	close(doorbell[1]);
+
+	worker->pid = pid;
+	worker->requests = requests[1];
+	worker->doorbell = doorbell[0];
+	worker->served = 0;
+	worker->queued = 0;
+
+	return 0;
+}
+//	close a worker's pipes and collect its exit status
+static int fork_worker_reap(ForkWorker *worker, int kill_first)
+{
+	int status = 0;
+	if (kill_first)
+		kill(worker->pid, SIGKILL);
+	close(worker->requests);
+	close(worker->doorbell);
+	while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR)
+		;
+	worker->pid = 0;
+
+	return status;
+}
+//	report every result the worker has published, queueing quarantined failures to `retry`
+//	when given; returns the number reported
+static int fork_worker_drain(RunState *run, TestSet set, TestCase *cases, ForkWorker *worker, int *retry, int *retries)
+{
+	int reported = 0;
+	SlotState commit;
+	ResultSlot *slot;
+	while ((slot = ring_front(worker->ring, &commit)) && commit == SLOT_DONE)
+	{
+		TestCase tc = cases[slot->index];
+		set_result(tc, slot->state, slot->message_len ? slot->message : NULL);
+		memcpy(tc->timings, slot->timings, sizeof(tc->timings));
+		tc->worker = worker->pid;
+		int index = slot->index;
+		ring_release(worker->ring);
+		worker->queued--;
+		memmove(worker->queue, worker->queue + 1, sizeof(int) * worker->queued);
+
+		tc->attempts++;
+		if (retry && retry_case(run, set, tc))
+		{
+			retry[(*retries)++] = index;
+			continue;
+		}
+		report_detached_case(run, set, tc);
+		reported++;
+	}
+
+	return reported;
+}
+/*
+	A worker died or was killed: report what it published, blame the case it had in hand
+	and hand the rest of its queue back; returns the number reported
+*/
+static int fork_worker_lost(RunState *run, TestSet set, TestCase *cases, ForkWorker *worker, int timed_out,
+									 int *retry, int *retries)
+{
+	int reported = fork_worker_drain(run, set, cases, worker, retry, retries);
+	pid_t pid = worker->pid;
+	int status = fork_worker_reap(worker, timed_out);
+	if (!worker->queued)
+		return reported;
+
+	// an open slot is a partial record: the case started and never finished
+	SlotState commit = SLOT_EMPTY;
+	ResultSlot *slot = ring_front(worker->ring, &commit);
+	TestCase tc = cases[worker->queue[0]];
+	char message[128];
+	if (timed_out)
+		snprintf(message, sizeof(message), "Timed out after %.0f ms; worker killed", case_timeout(run, set, tc));
+	else if (WIFSIGNALED(status))
+		snprintf(message, sizeof(message), "Crashed: worker killed by %s", strsignal(WTERMSIG(status)));
+	else
+		snprintf(message, sizeof(message), "Crashed: worker exited with status %d", WEXITSTATUS(status));
+	set_result(tc, timed_out ? TIMEOUT : CRASH, message);
+	memset(tc->timings, 0, sizeof(tc->timings));
+	if (slot && commit == SLOT_OPEN)
+		end_phase(&tc->timings[PHASE_BODY], slot->started);
+	tc->worker = pid;
+	tc->attempts++;
+	int retried = retry_case(run, set, tc);
+	if (retried)
+		retry[(*retries)++] = worker->queue[0];
+	else
+		report_detached_case(run, set, tc);
+
+	for (int i = 1; i < worker->queued; i++)
+		retry[(*retries)++] = worker->queue[i];
+	worker->queued = 0;
+
+	return reported + !retried;
+}
+/*
+	Run a set's cases on a pool of `workers` forked workers, each recycled after `recycle`
+	cases (0 keeps a worker for the whole set); results are reported as they complete
+*/
+//	report a case the pool never ran: not run past the failure limit, failed when the pool broke down
+static void report_unrun(RunState *run, TestSet set, TestCase tc)
+{
+	if (run->cancelled)
+	{
+		report_not_run(run, set, tc);
+		return;
+	}
+	set_result(tc, FAIL, "Not run: no fork worker was left to run it");
+	memset(tc->timings, 0, sizeof(tc->timings));
+	tc->worker = 0;
+	report_case(run, set, tc);
+}
+static void run_forked(RunState *run, TestSet set, int workers, int recycle)
+{
+	int count = 0;
+	for (TestCase tc = set->cases; tc; tc = tc->next)
+		count++;
+	TestCase *cases = malloc(sizeof(TestCase) * (count ? count : 1));
+	if (!cases)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate worker pool; running %s in-process", set->name);
+		for (TestCase tc = set->cases; tc; tc = tc->next)
+		{
+			if (!run_resumed(run, set, tc))
+				run_in_process(run, set, tc);
+		}
+		return;
+	}
+	// cases an earlier run completed are reported without a worker
+	count = 0;
+	for (TestCase tc = set->cases; tc; tc = tc->next)
+	{
+		if (run_resumed(run, set, tc))
+			continue;
+		if (run->cancelled)
+			report_not_run(run, set, tc);
+		else
+			cases[count++] = tc;
+	}
+	if (count == 0)
+	{
+		free(cases);
+		return;
+	}
+	if (workers > count)
+		workers = count;
+
+	int *retry = malloc(sizeof(int) * count);
+	ForkWorker *pool = calloc(workers, sizeof(ForkWorker));
+	struct pollfd *fds = malloc(sizeof(struct pollfd) * workers);
+	int rings = 0;
+	while (pool && rings < workers && (pool[rings].ring = ring_create()))
+		rings++;
+	if (!retry || !pool || !fds || rings < workers)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate worker pool; running %s in-process", set->name);
+		for (int i = 0; i < count; i++)
+			run_in_process(run, set, cases[i]);
+		for (int i = 0; i < rings; i++)
+			ring_destroy(pool[i].ring);
+		free(cases);
+		free(retry);
+		free(pool);
+		free(fds);
+		return;
+	}
+
+	// a request to a worker that just died must fail with EPIPE, not kill the runner
+	struct sigaction ignore = {0};
+	ignore.sa_handler = SIG_IGN;
+	sigemptyset(&ignore.sa_mask);
+	sigaction(SIGPIPE, &ignore, &run->sigpipe);
+
+	int next = 0, retries = 0, reported = 0, spawned = 0;
+	while (reported < count && !run->cancelled)
+	{
+		// keep a warm worker in every slot while cases remain
+		for (int i = 0; i < workers && (retries || next < count); i++)
+		{
+			if (!pool[i].pid && fork_worker_spawn(run, set, cases, pool, i, workers, recycle) == 0)
+				spawned++;
+		}
+		// queue cases round-robin so a short set still spreads across the pool
+		for (int depth = 1; depth <= FORK_QUEUE_DEPTH; depth++)
+		{
+			for (int i = 0; i < workers && (retries || next < count); i++)
+			{
+				ForkWorker *worker = &pool[i];
+				if (!worker->pid || worker->queued >= depth || (recycle && worker->served >= recycle))
+					continue;
+				int index = retries ? retry[--retries] : next++;
+				worker->queue[worker->queued++] = index;
+				worker->served++;
+				if (write_full(worker->requests, &index, sizeof(index)) != 0)
+				{
+					// the worker is gone; its queue is settled when its doorbell hangs up
+					break;
+				}
+			}
+		}
+
+		// wait for a doorbell, or the nearest deadline of a started case
+		int active = 0;
+		double wait_ms = -1.0;
+		for (int i = 0; i < workers; i++)
+		{
+			ForkWorker *worker = &pool[i];
+			fds[i] = (struct pollfd){worker->pid ? worker->doorbell : -1, POLLIN, 0};
+			if (fds[i].fd < 0)
+				continue;
+			active++;
+			SlotState commit;
+			ResultSlot *slot = ring_front(worker->ring, &commit);
+			double timeout_ms = slot && commit == SLOT_OPEN ? case_timeout(run, set, cases[slot->index]) : 0.0;
+			if (timeout_ms > 0.0)
+			{
+				double left = timeout_ms - get_elapsed_ns(slot->started, sys_getticks()) / 1e6;
+				left = left > 0.0 ? left : 0.0;
+				wait_ms = wait_ms < 0.0 || left < wait_ms ? left : wait_ms;
+			}
+		}
+		if (run->progress)
+		{
+			progress_workers(run->progress, active);
+		}
+		if (!active && !spawned)
+		{
+			// fork is unavailable altogether: run the set as it would run without isolation
+			fwritelnf(stderr, "Warning: No fork workers could be started; running %s in-process", set->name);
+			for (; next < count; reported++)
+				run_in_process(run, set, cases[next++]);
+			break;
+		}
+		if (!active)
+		{
+			// workers ran and cannot be replaced; the pool cannot be rebuilt
+			fwritelnf(stderr, "Error: No fork workers available; failing the %d cases left", count - reported);
+			break;
+		}
+		int ready = poll(fds, workers, wait_ms < 0.0 ? -1 : (int)(wait_ms + 1.0));
+		if (ready < 0 && errno != EINTR)
+		{
+			fwritelnf(stderr, "Error: Failed to wait for fork workers: %s", strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < workers; i++)
+		{
+			ForkWorker *worker = &pool[i];
+			if (fds[i].fd < 0)
+				continue;
+			if (!fds[i].revents)
+			{
+				SlotState commit;
+				ResultSlot *slot = ring_front(worker->ring, &commit);
+				double timeout_ms = slot && commit == SLOT_OPEN ? case_timeout(run, set, cases[slot->index]) : 0.0;
+				if (timeout_ms > 0.0 && get_elapsed_ns(slot->started, sys_getticks()) / 1e6 >= timeout_ms)
+					reported += fork_worker_lost(run, set, cases, worker, TRUE, retry, &retries);
+				continue;
+			}
+
+			char bells[64];
+			ssize_t n = read(worker->doorbell, bells, sizeof(bells));
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n <= 0)
+			{
+				// hung up: either spent after its last case, or dead with cases in hand
+				reported += fork_worker_lost(run, set, cases, worker, FALSE, retry, &retries);
+				continue;
+			}
+			reported += fork_worker_drain(run, set, cases, worker, retry, &retries);
+		}
+	}
+
+	// cancelled, or the pool could not go on: keep what workers already published, stop them
+	// and report what they had queued, and every case never handed out, without running it
+	if (run->cancelled || reported < count)
+	{
+		for (int i = 0; i < workers; i++)
+		{
+			ForkWorker *worker = &pool[i];
+			if (!worker->pid)
+				continue;
+			fork_worker_drain(run, set, cases, worker, NULL, NULL);
+			fork_worker_reap(worker, TRUE);
+			for (int q = 0; q < worker->queued; q++)
+				report_unrun(run, set, cases[worker->queue[q]]);
+			worker->queued = 0;
+		}
+		while (retries)
+			report_unrun(run, set, cases[retry[--retries]]);
+		while (next < count)
+			report_unrun(run, set, cases[next++]);
+	}
+	// idle workers exit when their request pipe closes
+	for (int i = 0; i < workers; i++)
+	{
+		if (pool[i].pid)
+			fork_worker_reap(&pool[i], FALSE);
+		ring_destroy(pool[i].ring);
+	}
+	sigaction(SIGPIPE, &run->sigpipe, NULL);
+	if (run->progress)
+	{
+		progress_workers(run->progress, 0);
+	}
+	free(cases);
+	free(retry);
+	free(pool);
+	free(fds);
+}
+
+/*
+	Repeat modes: a case runs until its run limit, its time budget or, with until-fail, its
+	first failure, in-process or on forked workers sharing its runs; it is reported once
+*/
+//	may run `number` of a case started at `start` go ahead; the first run always does
+static int repeat_more(RunState *run, unsigned long long number, ts_tick start)
+{
+	if (number <= 1)
+		return TRUE;
+	if (run->repeat && number > run->repeat)
+		return FALSE;
+
+	return run->repeat_for_ms <= 0.0 || get_elapsed_ns(start, sys_getticks()) / 1e6 < run->repeat_for_ms;
+}
+static void repeat_in_process(RunState *run, TestSet set, TestCase tc, ts_tick start)
+{
+	// per-case hooks see the case once, when it is reported
+	SigtestHooks hooks = run->hooks;
+	run->hooks = NULL;
+	for (unsigned long long number = 1; repeat_more(run, number, start); number++)
+	{
+		set_result(tc, PASS, NULL);
+		execute_case(run, set, tc, TRUE);
+		TestState state = tc->test_result.state;
+		int failed = run_failed(tc, state);
+		repeat_record(tc->repeat, number, state, tc->timings[PHASE_BODY].ns, failed, tc->test_result.message);
+		// once the set is quarantined every later run would be skipped
+		if ((failed && run->until_fail) || run->quarantine_cause)
+			break;
+	}
+	run->hooks = hooks;
+}
+//	repeat worker loop: claim runs until they are spent, the case failed (until-fail) or the worker is recycled
+static void repeat_worker_main(RunState *run, TestSet set, TestCase tc, RepeatShared *shared, RepeatSlot *slot,
+										 int recycle, ts_tick start)
+{
+	run->hooks = NULL;
+	for (int served = 0; !recycle || served < recycle; served++)
+	{
+		if (__atomic_load_n(&shared->stop, __ATOMIC_ACQUIRE))
+			break;
+		unsigned long long number = __atomic_add_fetch(&shared->claimed, 1, __ATOMIC_ACQ_REL);
+		if (!repeat_more(run, number, start))
+			break;
+		slot->current = number;
+		slot->started = sys_getticks();
+		__atomic_store_n(&slot->running, TRUE, __ATOMIC_RELEASE);
+		set_result(tc, PASS, NULL);
+		execute_case(run, set, tc, FALSE);
+		TestState state = tc->test_result.state;
+		int failed = run_failed(tc, state);
+		repeat_record(&slot->stats, number, state, tc->timings[PHASE_BODY].ns, failed, tc->test_result.message);
+		__atomic_store_n(&slot->running, FALSE, __ATOMIC_RELEASE);
+		if (failed && run->until_fail)
+			__atomic_store_n(&shared->stop, TRUE, __ATOMIC_RELEASE);
+	}
+	fflush(NULL);
+	// skip atexit handlers; they belong to the parent
+	_exit(EXIT_SUCCESS);
+}
+//	fork a repeat worker into `slot`; its end of the hang-up pipe closes when it exits
+static pid_t repeat_worker_spawn(RunState *run, TestSet set, TestCase tc, RepeatShared *shared, int slot, int recycle,
+											ts_tick start, int *hangup)
+{
+	int hangups[2];
+	if (pipe(hangups) != 0)
+	{
+		fwritelnf(stderr, "Error: Failed to create worker pipe: %s", strerror(errno));
+		return 0;
+	}
+	// anything still buffered would otherwise be written twice
+	fflush(NULL);
+
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		fwritelnf(stderr, "Error: Failed to fork worker: %s", strerror(errno));
+		close(hangups[0]);
+		close(hangups[1]);
+		return 0;
+	}
+	if (pid == 0)
+	{
+		close(hangups[0]);
+		repeat_worker_main(run, set, tc, shared, &shared->slot[slot], recycle, start);
+	}
+	close(hangups[1]);
+	*hangup = hangups[0];
+
+	return pid;
+}
+/*
+	Spread a case's runs over `workers` forked workers, each recycled after `recycle` runs
+	(0 keeps it while runs remain); a worker lost mid-run has that run blamed on it and is
+	replaced. Returns FALSE, having run nothing, when no worker could be started
+*/
+static int repeat_forked(RunState *run, TestSet set, TestCase tc, int workers, int recycle, ts_tick start)
+{
+	RepeatShared *shared = repeat_shared_create(workers);
+	pid_t *pids = calloc(workers, sizeof(pid_t));
+	int *hangups = malloc(sizeof(int) * workers);
+	struct pollfd *fds = malloc(sizeof(struct pollfd) * workers);
+	if (!shared || !pids || !hangups || !fds)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate repeat workers");
+		repeat_shared_destroy(shared);
+		free(pids);
+		free(hangups);
+		free(fds);
+		return FALSE;
+	}
+
+	double timeout_ms = case_timeout(run, set, tc);
+	int spawned = 0;
+	for (;;)
+	{
+		// keep every slot busy while runs remain
+		int remain = !__atomic_load_n(&shared->stop, __ATOMIC_ACQUIRE) &&
+						 repeat_more(run, __atomic_load_n(&shared->claimed, __ATOMIC_ACQUIRE) + 1, start);
+		int active = 0;
+		for (int i = 0; i < workers; i++)
+		{
+			if (!pids[i] && remain && (pids[i] = repeat_worker_spawn(run, set, tc, shared, i, recycle, start, &hangups[i])))
+				spawned++;
+			active += pids[i] != 0;
+		}
+		if (run->progress)
+		{
+			progress_workers(run->progress, active);
+		}
+		if (!active)
+			break;
+
+		// wait for a worker to hang up, or the nearest deadline of a run under way
+		double wait_ms = -1.0;
+		for (int i = 0; i < workers; i++)
+		{
+			RepeatSlot *slot = &shared->slot[i];
+			fds[i] = (struct pollfd){pids[i] ? hangups[i] : -1, POLLIN, 0};
+			if (fds[i].fd < 0 || timeout_ms <= 0.0 || !__atomic_load_n(&slot->running, __ATOMIC_ACQUIRE))
+				continue;
+			double left = timeout_ms - get_elapsed_ns(slot->started, sys_getticks()) / 1e6;
+			left = left > 0.0 ? left : 0.0;
+			wait_ms = wait_ms < 0.0 || left < wait_ms ? left : wait_ms;
+		}
+		if (poll(fds, workers, wait_ms < 0.0 ? -1 : (int)(wait_ms + 1.0)) < 0 && errno != EINTR)
+		{
+			fwritelnf(stderr, "Error: Failed to wait for repeat workers: %s", strerror(errno));
+			break;
+		}
+
+		for (int i = 0; i < workers; i++)
+		{
+			RepeatSlot *slot = &shared->slot[i];
+			if (!pids[i])
+				continue;
+			int running = __atomic_load_n(&slot->running, __ATOMIC_ACQUIRE);
+			int overran = running && timeout_ms > 0.0 && get_elapsed_ns(slot->started, sys_getticks()) / 1e6 >= timeout_ms;
+			if (!fds[i].revents && !overran)
+				continue;
+
+			// the worker never writes: readable means it hung up
+			int status = 0;
+			if (overran)
+				kill(pids[i], SIGKILL);
+			close(hangups[i]);
+			while (waitpid(pids[i], &status, 0) < 0 && errno == EINTR)
+				;
+			pids[i] = 0;
+			if (!__atomic_load_n(&slot->running, __ATOMIC_ACQUIRE))
+				continue;
+
+			// the run it had in hand never finished
+			char message[128];
+			if (overran)
+				snprintf(message, sizeof(message), "Timed out after %.0f ms; worker killed", timeout_ms);
+			else if (WIFSIGNALED(status))
+				snprintf(message, sizeof(message), "Crashed: worker killed by %s", strsignal(WTERMSIG(status)));
+			else
+				snprintf(message, sizeof(message), "Crashed: worker exited with status %d", WEXITSTATUS(status));
+			TestState state = overran ? TIMEOUT : CRASH;
+			int failed = run_failed(tc, state);
+			repeat_record(&slot->stats, slot->current, state, get_elapsed_ns(slot->started, sys_getticks()), failed,
+							  message);
+			slot->running = FALSE;
+			if (failed && run->until_fail)
+				shared->stop = TRUE;
+		}
+	}
+
+	// only reached with workers left after a failed wait
+	for (int i = 0; i < workers; i++)
+	{
+		if (!pids[i])
+			continue;
+		kill(pids[i], SIGKILL);
+		close(hangups[i]);
+		while (waitpid(pids[i], NULL, 0) < 0 && errno == EINTR)
+			;
+	}
+	if (run->progress)
+	{
+		progress_workers(run->progress, 0);
+	}
+	for (int i = 0; i < workers; i++)
+		repeat_merge(tc->repeat, &shared->slot[i].stats);
+	repeat_shared_destroy(shared);
+	free(pids);
+	free(hangups);
+	free(fds);
+
+	return spawned > 0;
+}
+//	report a repeated case once: as its first failure when it had one, with the mean body time
+static void report_repeated(RunState *run, TestSet set, TestCase tc)
+{
+	RepeatStats *stats = tc->repeat;
+	if (!stats->runs)
+	{
+		// workers started and every one was lost before a run was recorded
+		set_result(tc, FAIL, "Not run: no repeat run completed");
+	}
+	else if (stats->failures)
+	{
+		char message[REPEAT_MESSAGE_MAX + 96];
+		snprintf(message, sizeof(message), "%s in %llu of %llu runs, first at run %llu%s%s", TEST_STATES[stats->failure],
+					stats->failures, stats->runs, stats->first_failure, *stats->message ? ": " : "", stats->message);
+		set_result(tc, stats->failure, message);
+	}
+	else
+	{
+		// an expected failure is reported as one, so report_case applies the expectation as usual
+		TestState state = tc->expect_fail || tc->expect_throw ? FAIL : PASS;
+		set_result(tc, stats->states[state] ? state : SKIP, NULL);
+	}
+	tc->timings[PHASE_BODY].ns = stats->runs ? stats->total_ns / stats->runs : 0.0;
+	tc->worker = 0;
+	run->repeat_runs += stats->runs;
+	report_detached_case(run, set, tc);
+}
+/*
+	Repeat each of a set's cases and report it once; with `workers` the runs of each case
+	are spread over that many forked workers, otherwise they run in-process
+*/
+static void run_repeated(RunState *run, TestSet set, int workers, int recycle)
+{
+	for (TestCase tc = set->cases; tc; tc = tc->next)
+	{
+		if (run_resumed(run, set, tc))
+			continue;
+		if (run->cancelled)
 		{
-			set->log_stream = stdout;
+			report_not_run(run, set, tc);
+			continue;
+		}
+		if (!tc->repeat && !(tc->repeat = malloc(sizeof(RepeatStats))))
+		{
+			fwritelnf(stderr, "Error: Failed to allocate repeat stats; `%s` runs once", tc->name);
+			execute_case(run, set, tc, TRUE);
+			report_case(run, set, tc);
+			continue;
+		}
+		memset(tc->repeat, 0, sizeof(RepeatStats));
+
+		ts_tick start = sys_getticks();
+		if (workers > 0 && !repeat_forked(run, set, tc, workers, recycle, start))
+		{
+			// fork is unavailable: repeat the rest of the set as it would repeat without workers
+			fwritelnf(stderr, "Warning: No repeat workers could be started; repeating %s in-process", set->name);
+			workers = 0;
+		}
+		if (workers <= 0)
+			repeat_in_process(run, set, tc, start);
+		report_repeated(run, set, tc);
+	}
+}
+
+//	move the cases the filter or tag selection leaves out to the set's filtered list; returns the cases selected
+static int select_cases(Filter *filter, TagExpr *tags, TestSet set)
+{
+	TestCase selected = NULL, tail = NULL;
+	int count = 0;
+	for (TestCase tc = set->cases, next; tc; tc = next)
+	{
+		next = tc->next;
+		if ((filter && !filter_match(filter, set->name, tc->name)) || (tags && !tag_expr_match(tags, tc->tags)))
+		{
+			tc->next = set->filtered;
+			set->filtered = tc;
+			continue;
+		}
+		tc->next = NULL;
+		if (tail)
+			tail->next = tc;
+		else
+			selected = tc;
+		tail = tc;
+		count++;
+	}
+	set->cases = selected;
+	set->tail = tail;
+	set->count = count;
+
+	return count;
+}
+//	relink a set's cases by history rank, keeping declaration order within a rank; returns the best rank
+static int order_cases(History *history, TestSet set)
+{
+	TestCase heads[HISTORY_STABLE + 1] = {NULL}, tails[HISTORY_STABLE + 1] = {NULL};
+	for (TestCase tc = set->cases, next; tc; tc = next)
+	{
+		next = tc->next;
+		int rank = history_rank(history, set, tc);
+		tc->next = NULL;
+		if (tails[rank])
+			tails[rank]->next = tc;
+		else
+			heads[rank] = tc;
+		tails[rank] = tc;
+	}
+
+	int best = -1;
+	set->cases = set->tail = NULL;
+	for (int rank = 0; rank <= HISTORY_STABLE; rank++)
+	{
+		if (!heads[rank])
+			continue;
+		if (best < 0)
+			best = rank;
+		if (set->tail)
+			set->tail->next = heads[rank];
+		else
+			set->cases = heads[rank];
+		set->tail = tails[rank];
+	}
+
+	return best < 0 ? HISTORY_STABLE : best;
+}
+
+/*
+	Shuffled order: splitmix64 streams feed Fisher-Yates shuffles. The set order comes from
+	the seed; each set's case order from the seed and the set's name, so a set keeps its
+	shuffled case order when a filter leaves out other sets
+*/
+static unsigned long long shuffle_next(unsigned long long *state)
+{
+	unsigned long long z = (*state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+	return z ^ (z >> 31);
+}
+//	uniform in [0, bound) without the bias of a modulo
+static int shuffle_below(unsigned long long *state, int bound)
+{
+	return (int)(((unsigned __int128)shuffle_next(state) * (unsigned)bound) >> 64);
+}
+static void shuffle_cases(unsigned long long seed, TestSet set)
+{
+	TestCase *cases = malloc(sizeof(TestCase) * (set->count ? set->count : 1));
+	if (!cases)
+	{
+		fwritelnf(stderr, "Warning: Failed to allocate the shuffle of `%s`; its cases run in order", set->name);
+		return;
+	}
+	int count = 0;
+	for (TestCase tc = set->cases; tc; tc = tc->next)
+		cases[count++] = tc;
+
+	unsigned long long state = seed ^ test_id_hash(set->name, "");
+	for (int i = count - 1; i > 0; i--)
+	{
+		int j = shuffle_below(&state, i + 1);
+		TestCase swap = cases[i];
+		cases[i] = cases[j];
+		cases[j] = swap;
+	}
+	set->cases = set->tail = NULL;
+	for (int i = 0; i < count; i++)
+	{
+		cases[i]->next = NULL;
+		if (set->tail)
+			set->tail->next = cases[i];
+		else
+			set->cases = cases[i];
+		set->tail = cases[i];
+	}
+	free(cases);
+}
+/*
+	Hunt order dependencies: run the suite under `orders` shuffled orders, each in a forked
+	child with its own seed, `workers` at a time, and report the seeds that failed
+*/
+static int shuffle_hunt(TestSet sets, unsigned long long seed, int orders, int workers)
+{
+	unsigned long long *seeds = malloc(sizeof(unsigned long long) * orders);
+	pid_t *pids = calloc(orders, sizeof(pid_t));
+	if (!seeds || !pids)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate the shuffled orders");
+		free(seeds);
+		free(pids);
+		return EXIT_FAILURE;
+	}
+	unsigned long long state = seed;
+	for (int i = 0; i < orders; i++)
+		seeds[i] = i ? shuffle_next(&state) : seed;
+	// each order runs alone in its child: one order apiece, in-process, leaving the shared files alone
+	unsetenv("SIGTEST_SHUFFLE_ORDERS");
+	unsetenv("SIGTEST_WORKERS");
+	unsetenv("SIGTEST_HISTORY");
+	unsetenv("SIGTEST_ORDER");
+	unsetenv("SIGTEST_QUARANTINE");
+	unsetenv("SIGTEST_TREND");
+	unsetenv("SIGTEST_PROGRESS");
+	unsetenv("SIGTEST_JOURNAL");
+	unsetenv("SIGTEST_RESUME");
+	unsetenv("SIGTEST_PROFILE");
+
+	fwritelnf(stdout, "Hunting order dependencies: %d shuffled orders, %d at a time", orders, workers);
+	int started = 0, running = 0, failed = 0;
+	while (started < orders || running)
+	{
+		while (started < orders && running < workers)
+		{
+			char value[32];
+			snprintf(value, sizeof(value), "%llu", seeds[started]);
+			fflush(NULL);
+			pid_t pid = fork();
+			if (pid == 0)
+			{
+				/*
+					the seeds and outcomes are the report; a failing order is replayed to read its output.
+					Orders run side by side, so none writes the set logs or the hook outputs
+					(JSON, JUnit, binary, trace): every set logs to /dev/null through the default hooks
+				*/
+				setenv("SIGTEST_SHUFFLE", value, 1);
+				freopen("/dev/null", "w", stdout);
+				freopen("/dev/null", "w", stderr);
+				null_output = TRUE;
+				int result = run_tests(sets, (SigtestHooks)&default_hooks);
+				fflush(NULL);
+				_exit(result);
+			}
+			if (pid < 0)
+			{
+				fwritelnf(stderr, "Error: Failed to fork shuffled order: %s", strerror(errno));
+				orders = started;
+				break;
+			}
+			pids[started++] = pid;
+			running++;
+		}
+		if (!running)
+			break;
+
+		int status = 0;
+		pid_t pid = wait(&status);
+		if (pid < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (int i = 0; i < started; i++)
+		{
+			if (pids[i] != pid)
+				continue;
+			pids[i] = 0;
+			running--;
+			int passed = WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+			failed += !passed;
+			if (WIFSIGNALED(status))
+				fwritelnf(stdout, "  seed %-20llu  CRASH (%s)", seeds[i], strsignal(WTERMSIG(status)));
+			else
+				fwritelnf(stdout, "  seed %-20llu  %s", seeds[i], passed ? "PASS" : "FAIL");
+		}
+	}
+	fwritelnf(stdout, "=================================================================");
+	if (failed)
+		fwritelnf(stdout, "%d of %d shuffled orders failed; replay one with --shuffle=<seed>", failed, orders);
+	else
+		fwritelnf(stdout, "All %d shuffled orders passed", orders);
+	free(seeds);
+	free(pids);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// the actual test runner
+int run_tests(TestSet sets, SigtestHooks test_hooks)
+{
+	int set_sequence = 1;
+	char timestamp[32];
+
+	// Log total registered test sets for debugging
+	int total_sets = 0;
+	SigtestHooks hooks = NULL;
+	for (TestSet set = sets; set; set = set->next)
+	{
+		/*
+			We need to check if we have a test_hooks set; if not we need to use the default hooks.
+			If we have a set->hooks, and a test_hooks, we need to prioritize the test_hooks.
+
+			CLI options:
+			  `-s`: simple mode, no hooks will be provided by the test runner; however, the test
+					  set could register hooks and those will be used.
+				default (no flag): the test runner can provide hooks intended to override the test
+					  set hooks. If NULL is passed, then the default hooks will be used.
+		 */
+		if (!test_hooks && !set->hooks)
+		{
+			//	set the default hooks
+			hooks = hook_registry->hooks;
+		}
+		else if (test_hooks)
+		{
+			hooks = test_hooks;
+		}
+		else
+		{
+			hooks = set->hooks;
+		}
+
+		total_sets++;
+	}
+	// duplicate ids were reported at registration: SIGTEST_DUPLICATES=error refuses to run them
+	const char *duplicates = getenv("SIGTEST_DUPLICATES");
+	if (duplicate_ids && duplicates && strcmp(duplicates, "error") == 0)
+	{
+		fwritelnf(stderr, "Error: %d duplicate test ids registered", duplicate_ids);
+		return EXIT_FAILURE;
+	}
+	// test selection: SIGTEST_FILTER=<patterns>, compiled once for the whole registry
+	Filter *filter = NULL;
+	const char *filter_spec = getenv("SIGTEST_FILTER");
+	if (filter_spec && *filter_spec && !(filter = filter_compile(filter_spec)))
+	{
+		return EXIT_FAILURE;
+	}
+	// tag selection: SIGTEST_TAGS=<expression>, e.g. "fast & !flaky"
+	TagExpr *tags = NULL;
+	const char *tags_spec = getenv("SIGTEST_TAGS");
+	if (tags_spec && *tags_spec && !(tags = tag_expr_compile(tags_spec)))
+	{
+		filter_free(filter);
+		return EXIT_FAILURE;
+	}
+	// list mode: SIGTEST_LIST=json|binary writes a manifest (to SIGTEST_MANIFEST or stdout) and runs nothing
+	const char *list = getenv("SIGTEST_LIST");
+	if (list && *list)
+	{
+		int listed = sigtest_list(sets, filter, tags, list, getenv("SIGTEST_MANIFEST"));
+		filter_free(filter);
+		tag_expr_free(tags);
+		return listed;
+	}
+	if (total_sets == 0)
+	{
+		filter_free(filter);
+		tag_expr_free(tags);
+		return 0;
+	}
+	// shuffled order: SIGTEST_SHUFFLE=<seed>|random; SIGTEST_SHUFFLE_ORDERS=<n> hunts
+	const char *shuffle = getenv("SIGTEST_SHUFFLE");
+	const char *orders = getenv("SIGTEST_SHUFFLE_ORDERS");
+	int shuffling = (shuffle && *shuffle && strcmp(shuffle, "0") != 0) || (orders && atoi(orders) > 1);
+	unsigned long long seed = 0;
+	if (shuffling)
+	{
+		seed = shuffle && strcmp(shuffle, "random") != 0 ? strtoull(shuffle, NULL, 10) : 0;
+		if (!seed)
+		{
+			ts_time now;
+			sys_gettime(&now);
+			unsigned long long state = (unsigned long long)now.tv_nsec ^ ((unsigned long long)now.tv_sec << 30) ^ getpid();
+			seed = shuffle_next(&state);
+		}
+		if (orders && atoi(orders) > 1)
+		{
+			const char *workers = getenv("SIGTEST_WORKERS");
+			int hunters = workers && strcmp(workers, "auto") != 0 ? atoi(workers) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+			filter_free(filter);
+			tag_expr_free(tags);
+			return shuffle_hunt(sets, seed, atoi(orders), hunters > 0 ? hunters : 1);
+		}
+		fwritelnf(stdout, "Shuffled with seed %llu; replay with --shuffle=%llu", seed, seed);
+	}
+	// calibrate the test clock before the first case is timed
+	sys_clock_init();
+	// opt-in sampling profiler: SIGTEST_PROFILE=<folded stacks file>
+	const char *profile_path = getenv("SIGTEST_PROFILE");
+	if (profile_path && *profile_path)
+	{
+		const char *hz = getenv("SIGTEST_PROFILE_HZ");
+		const char *threshold = getenv("SIGTEST_PROFILE_MIN_US");
+		profile_start(profile_path, hz ? atoi(hz) : 0, threshold ? atof(threshold) : 0.0);
+	}
+
+	RunState *run = calloc(1, sizeof(RunState));
+	if (!run)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate runner state");
+		return EXIT_FAILURE;
+	}
+	run->hooks = hooks;
+	// global test body timeout: SIGTEST_TIMEOUT_MS=<ms>
+	const char *timeout = getenv("SIGTEST_TIMEOUT_MS");
+	run->timeout_ms = timeout ? atof(timeout) : 0.0;
+	// crash containment: SIGTEST_CRASH_GUARD=on|quarantine
+	const char *guard = getenv("SIGTEST_CRASH_GUARD");
+	run->crash_guard = guard && *guard && strcmp(guard, "0") != 0 && strcmp(guard, "off") != 0;
+	run->crash_quarantine = run->crash_guard && strcmp(guard, "quarantine") == 0;
+	if (run->crash_guard && crash_guard_install() != 0)
+	{
+		run->crash_guard = FALSE;
+	}
+	// forked isolation for every set: SIGTEST_FORK=<cases per worker>, SIGTEST_WORKERS=<pool size>
+	const char *fork_batch = getenv("SIGTEST_FORK");
+	run->fork_batch = fork_batch ? atoi(fork_batch) : 0;
+	const char *workers = getenv("SIGTEST_WORKERS");
+	run->workers = workers ? atoi(workers) : 0;
+	if (workers && strcmp(workers, "auto") == 0)
+	{
+		run->workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	// repeat modes: SIGTEST_REPEAT=<runs>, SIGTEST_REPEAT_FOR=<duration>, SIGTEST_UNTIL_FAIL
+	const char *repeat = getenv("SIGTEST_REPEAT");
+	const char *repeat_for = getenv("SIGTEST_REPEAT_FOR");
+	const char *until_fail = getenv("SIGTEST_UNTIL_FAIL");
+	run->repeat = repeat ? strtoull(repeat, NULL, 10) : 0;
+	run->repeat_for_ms = repeat_for && *repeat_for ? repeat_duration_ms(repeat_for) : 0.0;
+	if (run->repeat_for_ms < 0.0)
+	{
+		fwritelnf(stderr, "Warning: Invalid repeat duration '%s' (e.g. 500ms, 90s, 2m); not repeating for a time", repeat_for);
+		run->repeat_for_ms = 0.0;
+	}
+	run->until_fail = until_fail && *until_fail && strcmp(until_fail, "0") != 0;
+	run->repeating = run->repeat || run->repeat_for_ms > 0.0 || run->until_fail;
+	// fail fast: SIGTEST_MAX_FAILURES=<n> stops running cases after n failures
+	const char *max_failures = getenv("SIGTEST_MAX_FAILURES");
+	run->max_failures = max_failures ? atoi(max_failures) : 0;
+	// completion journal: SIGTEST_JOURNAL=<file>; SIGTEST_RESUME skips the cases it holds
+	const char *journal = getenv("SIGTEST_JOURNAL");
+	const char *resume = getenv("SIGTEST_RESUME");
+	int resuming = resume && *resume && strcmp(resume, "0") != 0;
+	if ((journal && *journal) || resuming)
+	{
+		run->journal = journal_open(journal && *journal ? journal : SIGTEST_JOURNAL_DEFAULT, resuming);
+	}
+
+	// result store: SIGTEST_HISTORY=<file>; SIGTEST_ORDER=failed-first runs likely failures first
+	const char *history = getenv("SIGTEST_HISTORY");
+	const char *order = getenv("SIGTEST_ORDER");
+	int failed_first = order && strcmp(order, "failed-first") == 0;
+	if (order && !failed_first && strcmp(order, "declared") != 0)
+	{
+		fwritelnf(stderr, "Warning: Unknown test order '%s'; running in declared order", order);
+	}
+	if (failed_first && shuffling)
+	{
+		fwritelnf(stderr, "Warning: --order=failed-first is ignored while shuffling");
+		failed_first = FALSE;
+	}
+	// flaky quarantine: SIGTEST_QUARANTINE[=<flip rate>]; SIGTEST_RETRIES=<n> reruns quarantined failures
+	const char *quarantine = getenv("SIGTEST_QUARANTINE");
+	if (quarantine && *quarantine && strcmp(quarantine, "0") != 0)
+	{
+		run->quarantine_rate = strcmp(quarantine, "1") == 0 ? HISTORY_FLAKY_RATE : atof(quarantine);
+		if (run->quarantine_rate <= 0.0 || run->quarantine_rate > 1.0)
+		{
+			fwritelnf(stderr, "Warning: Invalid quarantine flip rate '%s'; using %.2f", quarantine, HISTORY_FLAKY_RATE);
+			run->quarantine_rate = HISTORY_FLAKY_RATE;
+		}
+	}
+	const char *retries = getenv("SIGTEST_RETRIES");
+	run->retries = retries ? atoi(retries) : 0;
+	// duration trend: SIGTEST_TREND[=<file>] against the result store; SIGTEST_SLOWDOWN=<ratio> flags regressions
+	const char *trend = getenv("SIGTEST_TREND");
+	if (trend && *trend && strcmp(trend, "0") != 0)
+	{
+		const char *slowdown = getenv("SIGTEST_SLOWDOWN");
+		const char *top = getenv("SIGTEST_TREND_TOP");
+		if (slowdown && atof(slowdown) <= 1.0)
+		{
+			fwritelnf(stderr, "Warning: Invalid slowdown ratio '%s'; using %.2f", slowdown, TREND_SLOWDOWN);
+		}
+		run->trend = trend_open(slowdown ? atof(slowdown) : TREND_SLOWDOWN, top ? atoi(top) : TREND_TOP);
+	}
+	if ((history && *history) || failed_first || run->quarantine_rate > 0.0 || run->trend)
+	{
+		run->history = history_open(history && *history ? history : SIGTEST_HISTORY_DEFAULT);
+	}
+	// select the sets to run and order them by their most likely failure; the registry itself
+	// is left as registered
+	TestSet *ordered = malloc(sizeof(TestSet) * total_sets);
+	if (!ordered)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate runner state");
+		history_close(run->history);
+		trend_close(run->trend);
+		journal_close(run->journal);
+		filter_free(filter);
+		tag_expr_free(tags);
+		free(run);
+		return EXIT_FAILURE;
+	}
+	int *ranks = failed_first && run->history ? calloc(total_sets, sizeof(int)) : NULL;
+	int count = 0, registered = 0, selected = 0;
+	for (TestSet set = sets; set; set = set->next)
+	{
+		registered += set->count;
+		// a set with nothing selected is never configured, run or cleaned up
+		if ((filter || tags) && !select_cases(filter, tags, set))
+			continue;
+		selected += set->count;
+		// flakiness is read before anything runs, so a case is quarantined by its earlier runs only
+		for (TestCase tc = set->cases; run->history && tc; tc = tc->next)
+		{
+			tc->flip_rate = history_flip_rate(run->history, set, tc);
+			tc->quarantined = run->quarantine_rate > 0.0 && tc->flip_rate >= run->quarantine_rate;
+		}
+		if (shuffling)
+			shuffle_cases(seed, set);
+		int rank = ranks ? order_cases(run->history, set) : 0;
+		int at = count++;
+		for (; at > 0 && ranks && ranks[at - 1] > rank; at--)
+		{
+			ordered[at] = ordered[at - 1];
+			ranks[at] = ranks[at - 1];
 		}
+		ordered[at] = set;
+		if (ranks)
+			ranks[at] = rank;
+	}
+	free(ranks);
+	unsigned long long state = seed;
+	for (int i = count - 1; shuffling && i > 0; i--)
+	{
+		int j = shuffle_below(&state, i + 1);
+		TestSet swap = ordered[i];
+		ordered[i] = ordered[j];
+		ordered[j] = swap;
+	}
+
+	// batched result delivery
+	if (hooks && hooks->on_results_batch)
+	{
+		run->batch_size = hooks->batch_size > 0 ? hooks->batch_size : SIGTEST_BATCH_SIZE;
+		if (run->batch_size > SIGTEST_MAX_BATCH)
+			run->batch_size = SIGTEST_MAX_BATCH;
+	}
+	// live progress: SIGTEST_PROGRESS draws a status line on stderr, only when it is a terminal
+	const char *progress = getenv("SIGTEST_PROGRESS");
+	if (progress && *progress && strcmp(progress, "0") != 0 && isatty(STDERR_FILENO))
+	{
+		run->progress = progress_start(ordered, count, run->history, STDERR_FILENO);
+	}
+
+	for (int index = 0; index < count; index++, set_sequence++)
+	{
+		TestSet set = ordered[index];
+		run->total = run->passed = run->failed = run->skipped = run->not_run = run->quarantined = 0;
+		run->quarantine_cause = NULL;
+		run->batch_count = 0;
 		// Set current_set to the executing set for writef/debugf
 		current_set = set;
+		// past the failure limit the remaining sets are only counted
+		if (run->cancelled)
+		{
+			if (run->progress)
+				progress_set(run->progress, set);
+			skip_cancelled_set(run, set);
+			continue;
+		}
+		// the line is held off the terminal while a set opens or closes, never per case
+		if (run->progress)
+		{
+			progress_hold(run->progress);
+			progress_set(run->progress, set);
+		}
+		configure_set(set);
+		if (!set->log_stream || !set->logger)
+		{
+			set->log_stream = stdout;
+		}
+		// a set logging to a terminal writes there per case: the line stays held until it closes
+		int log_tty = run->progress && isatty(fileno(set->log_stream));
 
 		// Call before_set hook if defined
 		if (hooks && hooks->before_set)
@@ -1088,136 +3182,50 @@ int run_tests(TestSet sets, SigtestHooks test_hooks)
 						 set_sequence, set->name, set->count, ":", timestamp);
 			fwritelnf(set->log_stream, "=================================================================");
 		}
-
-		for (TestCase tc = set->cases; tc; tc = tc->next)
+		if (run->progress && !log_tty)
 		{
-			set->current = tc; // Set current test for set_test_context
-			//	before test case setup
-			if (hooks && hooks->before_test)
-			{
-				hooks->before_test(hooks->context);
-			}
-			//	test case setup
-			if (set->setup)
-			{
-				set->setup();
-			}
-			// on start test handler
-			if (hooks && hooks->on_start_test)
-			{
-				hooks->on_start_test(hooks->context);
-			}
-			//	test case execution
-			if (setjmp(jmpbuffer) == 0)
-			{
-				tc->test_func();
-			}
-			else
-			{
-				// Longjmp triggered by an assertion failure (FAIL, SKIP, etc.)
-				/*
-					We can add a custom handler for `on_exception`, `on_fail`, `on_skip`
-				 */
-			}
-			// on end test handler
-			if (hooks && hooks->on_end_test)
-			{
-				hooks->on_end_test(hooks->context);
-			}
-			//	test case teardown
-			if (set->teardown)
-			{
-				set->logger->log("Running teardown");
-				set->teardown();
-			}
-			//	after test case teardown
-			if (hooks && hooks->after_test)
-			{
-				hooks->after_test(hooks->context);
-			}
+			progress_release(run->progress);
+		}
 
-			// process test result
-			if (tc->expect_fail)
-			{
-				if (tc->test_result.state == FAIL)
-				{
-					tc->test_result.state = PASS;
-					if (tc->test_result.message)
-					{
-						free(tc->test_result.message);
-						tc->test_result.message = strdup("Expected failure occurred");
-					}
-				}
-				else if (tc->test_result.state != SKIP)
-				{
-					tc->test_result.state = FAIL;
-					if (tc->test_result.message)
-						free(tc->test_result.message);
-					tc->test_result.message = strdup("Expected failure but passed");
-				}
-			}
-			else if (tc->expect_throw)
-			{
-				if (tc->test_result.state == FAIL)
-				{
-					tc->test_result.state = PASS;
-					if (tc->test_result.message)
-					{
-						free(tc->test_result.message);
-						tc->test_result.message = strdup("Expected throw occurred");
-					}
-				}
-				else if (tc->test_result.state != SKIP)
-				{
-					tc->test_result.state = FAIL;
-					if (tc->test_result.message)
-						free(tc->test_result.message);
-					tc->test_result.message = strdup("Expected throw but passed");
-				}
-			}
-			//	process test result
-			if (tc->test_result.state == PASS)
-			{
-				if (hooks && hooks->on_test_result)
-				{
-					hooks->on_test_result(set, tc, hooks->context);
-				}
-				else
-				{
-					set->logger->log("[PASS]\n");
-				}
-				tc_passed++;
-				set->passed++;
-			}
-			else if (tc->test_result.state == SKIP)
-			{
-				if (hooks && hooks->on_test_result)
-				{
-					hooks->on_test_result(set, tc, hooks->context);
-				}
-				else
-				{
-					set->logger->log("[SKIP]\n");
-				}
-				tc_skipped++;
-				set->skipped++;
-			}
-			else
+		int fork_cases = set->fork_batch > 0 ? set->fork_batch : run->fork_batch;
+		if (run->repeating)
+		{
+			// workers share the runs of one case at a time
+			int repeat_workers = run->workers > 0 ? run->workers : fork_cases > 0;
+			run_repeated(run, set, repeat_workers, fork_cases);
+		}
+		else if (fork_cases > 0 || run->workers > 0)
+		{
+			// workers inherit the configured set copy-on-write; a lost worker costs one case
+			run_forked(run, set, run->workers > 0 ? run->workers : 1, fork_cases);
+		}
+		else
+		{
+			for (TestCase tc = set->cases; tc; tc = tc->next)
 			{
-				if (hooks && hooks->on_test_result)
-				{
-					hooks->on_test_result(set, tc, hooks->context);
-				}
-				else
-				{
-					set->logger->log("[FAIL]\n     %s", tc->test_result.message ? tc->test_result.message : "Unknown");
-				}
-				tc_failed++;
-				set->failed++;
+				if (!run_resumed(run, set, tc))
+					run_in_process(run, set, tc);
 			}
-			tc_total++;
-			total_tests++;
-			set->current = NULL;
+		}
+		// deliver the remaining batched results before closing the set
+		if (run->batch_count)
+		{
+			hooks->on_results_batch(set, run->batch, run->batch_count, hooks->context);
+		}
+		if (run->journal)
+		{
+			journal_sync(run->journal);
+		}
+		// set cleanup runs ahead of after_set so reporters see its timing
+		ts_tick cleanup_start = sys_getticks();
+		if (set->cleanup)
+		{
+			set->cleanup();
+		}
+		end_phase(&set->cleanup_time, cleanup_start);
+		if (run->progress && !log_tty)
+		{
+			progress_hold(run->progress);
 		}
 		// Call after_set hook if defined
 		if (hooks && hooks->after_set)
@@ -1228,22 +3236,77 @@ int run_tests(TestSet sets, SigtestHooks test_hooks)
 		{
 			fwritelnf(set->log_stream, "=================================================================");
 			fwritelnf(set->log_stream, "[%d]     TESTS=%3d        PASS=%3d        FAIL=%3d        SKIP=%3d",
-						 set_sequence, tc_total, tc_passed, tc_failed, tc_skipped);
+						 set_sequence, run->total, run->passed, run->failed, run->skipped);
+			fwritelnf(set->log_stream, "[%d]     CONFIG= %10.3f us      CLEANUP= %10.3f us",
+						 set_sequence, set->config_time.ns / 1000.0, set->cleanup_time.ns / 1000.0);
+			if (run->not_run)
+			{
+				fwritelnf(set->log_stream, "[%d]     NOT RUN=%3d", set_sequence, run->not_run);
+			}
+			if (run->quarantined)
+			{
+				fwritelnf(set->log_stream, "[%d]     QUARANTINED=%3d", set_sequence, run->quarantined);
+			}
 		}
-
-		if (set->cleanup)
+		if (run->progress)
 		{
-			set->cleanup();
+			progress_release(run->progress);
 		}
 	}
 
+	profile_stop();
+	progress_stop(run->progress);
+
 	// Final output to stdout
 	fwritelnf(stdout, "=================================================================");
 	fwritelnf(stdout, "Tests run: %d, Passed: %d, Failed: %d, Skipped: %d",
-				 total_tests, current_set->passed, current_set->failed, current_set->skipped);
+				 run->total_tests, run->total_passed, run->failures, run->total_skipped);
 	fwritelnf(stdout, "Total test sets registered: %d", total_sets);
+	if (filter || tags)
+	{
+		fwritelnf(stdout, "Selected: %d of %d cases", selected, registered);
+		if (!selected)
+			fwritelnf(stderr, "Warning: The filter and tag selection left no test cases to run");
+		filter_free(filter);
+		tag_expr_free(tags);
+	}
+	if (run->repeating)
+	{
+		fwritelnf(stdout, "Repeated: %llu runs", run->repeat_runs);
+	}
+	if (run->total_quarantined)
+	{
+		fwritelnf(stdout, "Quarantined: %d flaky cases failed without failing the run", run->total_quarantined);
+	}
+	if (run->cancelled)
+	{
+		fwritelnf(stdout, "Stopped after %d failures: %d cases not run", run->failures, run->total_not_run);
+	}
+	if (run->journal)
+	{
+		if (journal_restored(run->journal))
+			fwritelnf(stdout, "Resumed: %d cases completed by an earlier run", journal_restored(run->journal));
+		journal_close(run->journal);
+	}
+	int regressed = FALSE;
+	if (run->trend)
+	{
+		int regressions = trend_report(run->trend, strcmp(trend, "1") != 0 ? trend : NULL);
+		const char *max_regressions = getenv("SIGTEST_MAX_REGRESSIONS");
+		if (max_regressions && *max_regressions && regressions > atoi(max_regressions))
+		{
+			fwritelnf(stdout, "Failed: %d duration regressions, over the limit of %d", regressions, atoi(max_regressions));
+			regressed = TRUE;
+		}
+		trend_close(run->trend);
+	}
+	history_close(run->history);
+	free(ordered);
+	// any failure fails the run, in whichever set it was reported
+	int failed = run->failures > 0 || run->cancelled || regressed;
+	free(run);
 
-	return current_set->failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /*
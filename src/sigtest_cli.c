@@ -59,7 +59,7 @@ int main(int argc, char **argv)
 
    if (cli.state == ERROR)
    {
-      fwritelnf(stdout, "Usage: sigtest -t <path>|[-s|--no-clean|--about|[-v|--verbose]]\n");
+      fwritelnf(stdout, "Usage: sigtest -t <path>|[-s|--no-clean|<runner options>|--about|[-v|--verbose]]\n");
       return 1;
    }
 
@@ -205,6 +205,21 @@ void parse_args(int argc, char **argv, FILE *err_stream)
                cli.state = START;
             }
          }
+         else if (strncmp(argv[i], "--", 2) == 0)
+         {
+            // Runner options reach the test executable through its environment
+            int applied = sigtest_option(argv[i]);
+            if (applied < 0)
+            {
+               cli.state = ERROR;
+            }
+            else if (applied == 0)
+            {
+               // rejected as the test executable rejects it
+               fwritelnf(err_stream, "Error: Unknown option: '%s'", argv[i]);
+               cli.state = ERROR;
+            }
+         }
 
          break;
       }
@@ -0,0 +1,207 @@
+/*
+	sigtest_filter.c
+	Test selection by name
+
+	A filter is a comma-separated list of patterns over `set/case` ids, compiled once when
+	the run starts; `\,` puts a comma in a pattern, as in `re:^io/retry_[0-9]{1\,3}$`. A leading `-` makes a pattern exclude. `re:<regex>` is a POSIX extended
+	regex searched for in the whole `set/case` id (anchor it with ^ and $); anything else is
+	a glob. A glob with a `/` matches the set and case names separately; one without it
+	matches either name, so `math` selects a whole set and `*overflow*` a case in any set.
+	Globs without wildcards compare as plain strings.
+
+	A case is selected when no include pattern is given or one matches, and no exclude
+	pattern matches.
+*/
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <fnmatch.h>
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILTER_ID_MAX 512
+
+typedef struct FilterRule
+{
+	int exclude;
+	int is_regex;
+	regex_t regex;
+	char *set;		/* Set glob; NULL when the glob may match either name */
+	char *name;		/* Case glob, or the whole glob when `set` is NULL */
+	int set_literal; /* No wildcards: compare with strcmp */
+	int name_literal;
+} FilterRule;
+
+struct Filter
+{
+	int count;
+	int includes; /* Include rules; none selects everything not excluded */
+	FilterRule *rules;
+};
+
+static int is_literal(const char *glob)
+{
+	return !strpbrk(glob, "*?[\\");
+}
+static int glob_match(const char *glob, int literal, const char *name)
+{
+	return literal ? strcmp(glob, name) == 0 : fnmatch(glob, name, 0) == 0;
+}
+static int rule_compile(FilterRule *rule, const char *pattern)
+{
+	if (*pattern == '-')
+	{
+		rule->exclude = TRUE;
+		pattern++;
+	}
+	if (strncmp(pattern, "re:", 3) == 0)
+	{
+		int error = regcomp(&rule->regex, pattern + 3, REG_EXTENDED | REG_NOSUB);
+		if (error)
+		{
+			char reason[128];
+			regerror(error, &rule->regex, reason, sizeof(reason));
+			fwritelnf(stderr, "Error: Invalid filter regex '%s': %s", pattern + 3, reason);
+			return -1;
+		}
+		rule->is_regex = TRUE;
+		return 0;
+	}
+	if (!*pattern)
+	{
+		fwritelnf(stderr, "Error: Empty filter pattern");
+		return -1;
+	}
+
+	const char *slash = strchr(pattern, '/');
+	if (slash)
+	{
+		rule->set = strndup(pattern, slash - pattern);
+		rule->name = strdup(slash + 1);
+	}
+	else
+	{
+		rule->name = strdup(pattern);
+	}
+	if (!rule->name || (slash && !rule->set))
+	{
+		fwritelnf(stderr, "Error: Failed to allocate filter");
+		return -1;
+	}
+	rule->set_literal = rule->set && is_literal(rule->set);
+	rule->name_literal = is_literal(rule->name);
+
+	return 0;
+}
+static int rule_match(FilterRule *rule, const char *set, const char *name)
+{
+	if (rule->is_regex)
+	{
+		// the id is only built for regex rules, on the stack unless it is unusually long
+		char buffer[FILTER_ID_MAX];
+		size_t length = strlen(set) + strlen(name) + 2;
+		char *id = length <= sizeof(buffer) ? buffer : malloc(length);
+		if (!id)
+			return FALSE;
+		snprintf(id, length, "%s/%s", set, name);
+		int matched = regexec(&rule->regex, id, 0, NULL, 0) == 0;
+		if (id != buffer)
+			free(id);
+		return matched;
+	}
+	if (rule->set)
+		return glob_match(rule->set, rule->set_literal, set) && glob_match(rule->name, rule->name_literal, name);
+
+	return glob_match(rule->name, rule->name_literal, set) || glob_match(rule->name, rule->name_literal, name);
+}
+
+/*
+	Compile a filter spec; NULL when a pattern is invalid
+*/
+Filter *filter_compile(const char *spec)
+{
+	Filter *filter = calloc(1, sizeof(Filter));
+	char *patterns = strdup(spec);
+	int size = 1;
+	for (const char *c = spec; *c; c++)
+		size += *c == ',';
+	if (filter)
+		filter->rules = calloc(size, sizeof(FilterRule));
+	if (!filter || !patterns || !filter->rules)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate filter");
+		free(patterns);
+		filter_free(filter);
+		return NULL;
+	}
+
+	// split in place on the commas; `\,` is a comma within a pattern, other backslashes stay
+	char *pattern = patterns, *out = patterns;
+	for (const char *c = spec;; c++)
+	{
+		if (*c == '\\' && c[1] == ',')
+		{
+			*out++ = *++c;
+			continue;
+		}
+		if (*c && *c != ',')
+		{
+			*out++ = *c;
+			continue;
+		}
+		*out++ = '\0';
+		if (*pattern)
+		{
+			// counted first, so a half-compiled rule is freed with the rest
+			FilterRule *rule = &filter->rules[filter->count++];
+			if (rule_compile(rule, pattern) != 0)
+			{
+				free(patterns);
+				filter_free(filter);
+				return NULL;
+			}
+			filter->includes += !rule->exclude;
+		}
+		if (!*c)
+			break;
+		pattern = out;
+	}
+	free(patterns);
+
+	return filter;
+}
+/*
+	Is a case selected by the filter
+*/
+int filter_match(Filter *filter, const char *set, const char *name)
+{
+	int included = !filter->includes;
+	for (int i = 0; i < filter->count; i++)
+	{
+		FilterRule *rule = &filter->rules[i];
+		// excludes always get a look; includes only until one matches
+		if ((rule->exclude || !included) && rule_match(rule, set, name))
+		{
+			if (rule->exclude)
+				return FALSE;
+			included = TRUE;
+		}
+	}
+
+	return included;
+}
+void filter_free(Filter *filter)
+{
+	if (!filter)
+		return;
+
+	for (int i = 0; filter->rules && i < filter->count; i++)
+	{
+		if (filter->rules[i].is_regex)
+			regfree(&filter->rules[i].regex);
+		free(filter->rules[i].set);
+		free(filter->rules[i].name);
+	}
+	free(filter->rules);
+	free(filter);
+}
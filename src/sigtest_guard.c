@@ -0,0 +1,273 @@
+/*
+	sigtest_guard.c
+	Test case watchdog and crash containment
+
+	Each runner thread owns a POSIX timer that delivers SIGTEST_TIMEOUT_SIGNAL to that
+	thread only (SIGEV_THREAD_ID). When an armed timer expires the handler hands control
+	to the runner's expiry callback, which jumps back to the runner's recovery point. The
+	handler is installed with SA_NODEFER so the signal is not left blocked after the jump.
+
+	The crash guard handles SIGSEGV, SIGBUS, SIGFPE and SIGABRT on an alternate stack (a
+	stack overflow leaves no room on the faulting one). While a body is armed the handler
+	records the signal, faulting address and a backtrace into static storage, then hands
+	control to the runner's crash callback; `crash_describe` symbolizes it afterwards,
+	outside the handler. A fault outside an armed body gets the default action.
+
+	Jumping out of a hung or crashed body abandons whatever it was doing: locks it held
+	stay held and memory it allocated leaks. That is the price of keeping the run alive
+	in-process.
+*/
+#define _GNU_SOURCE
+#include "sigtest.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#define SIGTEST_TIMEOUT_SIGNAL (SIGRTMIN + 1)
+
+static __thread int timer_ready = 0;
+static __thread timer_t timer;
+static __thread volatile sig_atomic_t armed = 0;
+static __thread void (*volatile on_expire)(void) = NULL;
+static int handler_installed = 0;
+
+static void timeout_handler(int sig, siginfo_t *info, void *ucontext)
+{
+	(void)sig;
+	(void)info;
+	(void)ucontext;
+
+	// a late signal from a timer that was already disarmed is ignored
+	if (!armed || !on_expire)
+		return;
+
+	armed = 0;
+	on_expire();
+}
+
+static int timeout_init(void)
+{
+	if (!handler_installed)
+	{
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = timeout_handler;
+		action.sa_flags = SA_SIGINFO | SA_NODEFER;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(SIGTEST_TIMEOUT_SIGNAL, &action, NULL) != 0)
+		{
+			fwritelnf(stderr, "Error: Failed to install timeout handler: %s", strerror(errno));
+			return -1;
+		}
+		handler_installed = TRUE;
+	}
+	if (!timer_ready)
+	{
+		struct sigevent event;
+		memset(&event, 0, sizeof(event));
+		event.sigev_notify = SIGEV_THREAD_ID;
+		event.sigev_signo = SIGTEST_TIMEOUT_SIGNAL;
+		event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+		if (timer_create(CLOCK_MONOTONIC, &event, &timer) != 0)
+		{
+			fwritelnf(stderr, "Error: Failed to create timeout timer: %s", strerror(errno));
+			return -1;
+		}
+		timer_ready = TRUE;
+	}
+
+	return 0;
+}
+
+/*
+	Arm the calling thread's watchdog
+*/
+int timeout_arm(double ms, void (*expire)(void))
+{
+	if (ms <= 0.0 || !expire)
+		return 0;
+	if (timeout_init() != 0)
+		return -1;
+
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	spec.it_value.tv_sec = (time_t)(ms / 1000.0);
+	spec.it_value.tv_nsec = (long)((ms - spec.it_value.tv_sec * 1000.0) * 1000000.0);
+	if (!spec.it_value.tv_sec && !spec.it_value.tv_nsec)
+		spec.it_value.tv_nsec = 1;
+
+	on_expire = expire;
+	armed = 1;
+	if (timer_settime(timer, 0, &spec, NULL) != 0)
+	{
+		armed = 0;
+		fwritelnf(stderr, "Error: Failed to arm timeout timer: %s", strerror(errno));
+		return -1;
+	}
+
+	return 0;
+}
+/*
+	Disarm the calling thread's watchdog
+*/
+void timeout_disarm(void)
+{
+	if (!armed)
+		return;
+
+	armed = 0;
+	struct itimerspec spec;
+	memset(&spec, 0, sizeof(spec));
+	timer_settime(timer, 0, &spec, NULL);
+}
+
+#define CRASH_MAX_FRAMES 32
+#define CRASH_SHOWN_FRAMES 6
+#define CRASH_ALT_STACK (64 * 1024)
+
+static const int CRASH_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGABRT};
+#define CRASH_SIGNAL_COUNT ((int)(sizeof(CRASH_SIGNALS) / sizeof(CRASH_SIGNALS[0])))
+
+static __thread void *alt_stack = NULL;
+static __thread volatile sig_atomic_t crash_armed = 0;
+static __thread void (*volatile on_crash)(void) = NULL;
+static __thread struct
+{
+	int signal;
+	void *address;
+	void *pc; /* Faulting instruction */
+	int depth;
+	void *frames[CRASH_MAX_FRAMES];
+} crash;
+static int crash_installed = 0;
+
+static void crash_handler(int sig, siginfo_t *info, void *ucontext)
+{
+	if (!crash_armed || !on_crash)
+	{
+		// not ours to contain: default action
+		signal(sig, SIG_DFL);
+		raise(sig);
+		return;
+	}
+	crash_armed = 0;
+
+	crash.signal = sig;
+	crash.address = sig == SIGABRT ? NULL : info->si_addr;
+	crash.pc = NULL;
+#if defined(__x86_64__)
+	crash.pc = (void *)((ucontext_t *)ucontext)->uc_mcontext.gregs[REG_RIP];
+#elif defined(__aarch64__)
+	crash.pc = (void *)((ucontext_t *)ucontext)->uc_mcontext.pc;
+#endif
+	// backtrace was warmed up at install, so it no longer allocates
+	crash.depth = backtrace(crash.frames, CRASH_MAX_FRAMES);
+
+	on_crash();
+}
+
+/*
+	Install the crash handlers and the calling thread's alternate stack
+*/
+int crash_guard_install(void)
+{
+	if (!alt_stack)
+	{
+		stack_t stack;
+		memset(&stack, 0, sizeof(stack));
+		stack.ss_size = CRASH_ALT_STACK;
+		stack.ss_sp = malloc(stack.ss_size);
+		if (!stack.ss_sp || sigaltstack(&stack, NULL) != 0)
+		{
+			fwritelnf(stderr, "Error: Failed to set up crash guard stack");
+			free(stack.ss_sp);
+			return -1;
+		}
+		alt_stack = stack.ss_sp;
+	}
+	if (!crash_installed)
+	{
+		// the first backtrace loads the unwinder, which allocates; do it here
+		void *warm[1];
+		backtrace(warm, 1);
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = crash_handler;
+		action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_NODEFER;
+		sigemptyset(&action.sa_mask);
+		for (int i = 0; i < CRASH_SIGNAL_COUNT; i++)
+		{
+			if (sigaction(CRASH_SIGNALS[i], &action, NULL) != 0)
+			{
+				fwritelnf(stderr, "Error: Failed to install crash handler: %s", strerror(errno));
+				return -1;
+			}
+		}
+		crash_installed = TRUE;
+	}
+
+	return 0;
+}
+/*
+	Arm and disarm crash containment for the calling thread
+*/
+void crash_arm(void (*crashed)(void))
+{
+	if (!crash_installed)
+		return;
+
+	on_crash = crashed;
+	crash_armed = 1;
+}
+void crash_disarm(void)
+{
+	crash_armed = 0;
+}
+/*
+	Describe the last contained crash: signal, address and the innermost frames
+*/
+void crash_describe(char *buffer, size_t size)
+{
+	const char *name = crash.signal == SIGSEGV	 ? "SIGSEGV"
+							 : crash.signal == SIGBUS ? "SIGBUS"
+							 : crash.signal == SIGFPE ? "SIGFPE"
+														 : "SIGABRT";
+	int used = crash.signal != SIGABRT ? snprintf(buffer, size, "Crashed: %s at %p", name, crash.address)
+												  : snprintf(buffer, size, "Crashed: %s", name);
+
+	// skip the handler's own frames; the interrupted one matches the faulting pc
+	int first = 0;
+	for (int i = 0; i < crash.depth; i++)
+	{
+		if (crash.frames[i] == crash.pc)
+		{
+			first = i;
+			break;
+		}
+	}
+	for (int i = first; i < crash.depth && i < first + CRASH_SHOWN_FRAMES && used < (int)size; i++)
+	{
+		Dl_info info;
+		memset(&info, 0, sizeof(info));
+		// return addresses point past the call; step back into it
+		void *pc = (char *)crash.frames[i] - (i > first ? 1 : 0);
+		if (dladdr(pc, &info) && info.dli_sname)
+			used += snprintf(buffer + used, size - used, "%s%s", i == first ? " in " : " <- ", info.dli_sname);
+		else
+			used += snprintf(buffer + used, size - used, "%s%p", i == first ? " in " : " <- ", crash.frames[i]);
+	}
+}
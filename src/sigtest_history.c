@@ -0,0 +1,379 @@
+/*
+	sigtest_history.c
+	Persistent result store for test ordering
+
+	One line per test, keyed by its stable id (set and case name): the final state of its
+	latest run, a fingerprint of its body, the body nanoseconds, its recent outcomes and its
+	recent passing body times, tab separated. The fingerprint is the size of the test
+	function's symbol, read with dladdr1; it is cheap, survives relinking (unlike hashing the
+	code bytes, which relocations shift) and changes with most edits to the body. A body that
+	cannot be resolved fingerprints as 0.
+
+	The outcomes are the last HISTORY_WINDOW passes and failures (`P`, `F`, oldest first) of
+	the current fingerprint; an edit to the body starts them over. Their flip rate, the share
+	of consecutive outcomes that differ, is the case's flakiness: a case that fails steadily
+	is broken, one that alternates is flaky. The body times of its last HISTORY_DURATIONS
+	passes (comma separated) are the baseline its duration trend is measured against; a
+	failing run's time says little about the body's speed and is not kept. v1 stores, without
+	outcomes, and v2 stores, without body times, are still read.
+
+	The store is read once when the run starts and rewritten whole when it ends, through a
+	temporary file and rename(), so an interrupted run leaves the previous store intact.
+	Tests the run did not reach keep their earlier record.
+*/
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <link.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HISTORY_HEADER "# sigtest history v3\n"
+#define HISTORY_HEADER_V1 "# sigtest history v1\n"
+#define HISTORY_HEADER_V2 "# sigtest history v2\n"
+#define HISTORY_BUCKETS 1024
+
+typedef struct HistoryEntry
+{
+	struct HistoryEntry *next; /* Next in the bucket */
+	char *set;
+	char *name;
+	TestState state;			  /* Final state of the latest run */
+	unsigned long fingerprint;
+	double body_ns;
+	char outcomes[HISTORY_WINDOW + 1]; /* Recent passes and failures, oldest first */
+	double durations[HISTORY_DURATIONS]; /* Body times of recent passes, oldest first */
+	int duration_count;
+} HistoryEntry;
+
+struct History
+{
+	char *path;
+	int recorded; /* Cases recorded by this run */
+	HistoryEntry *buckets[HISTORY_BUCKETS];
+};
+
+static HistoryEntry *history_find(History *history, unsigned int hash, const char *set, const char *name)
+{
+	for (HistoryEntry *entry = history->buckets[hash % HISTORY_BUCKETS]; entry; entry = entry->next)
+	{
+		if (strcmp(entry->set, set) == 0 && strcmp(entry->name, name) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+static HistoryEntry *history_add(History *history, const char *set, const char *name)
+{
+	HistoryEntry *entry = calloc(1, sizeof(HistoryEntry));
+	if (!entry)
+		return NULL;
+	entry->set = strdup(set);
+	entry->name = strdup(name);
+	uint32_t bucket = test_id_hash(set, name) % HISTORY_BUCKETS;
+	entry->next = history->buckets[bucket];
+	history->buckets[bucket] = entry;
+
+	return entry;
+}
+static unsigned long fingerprint(TestCase tc)
+{
+	Dl_info info;
+	const ElfW(Sym) *symbol = NULL;
+	if (!tc->test_func || !dladdr1((void *)tc->test_func, &info, (void **)&symbol, RTLD_DL_SYMENT) || !symbol)
+		return 0;
+
+	return (unsigned long)symbol->st_size;
+}
+//	append an outcome, dropping the oldest once the window is full
+static void add_outcome(HistoryEntry *entry, char outcome)
+{
+	size_t length = strlen(entry->outcomes);
+	if (length == HISTORY_WINDOW)
+	{
+		memmove(entry->outcomes, entry->outcomes + 1, HISTORY_WINDOW - 1);
+		length--;
+	}
+	entry->outcomes[length] = outcome;
+	entry->outcomes[length + 1] = '\0';
+}
+//	append a passing body time, dropping the oldest once the window is full
+static void add_duration(HistoryEntry *entry, double body_ns)
+{
+	if (entry->duration_count == HISTORY_DURATIONS)
+	{
+		memmove(entry->durations, entry->durations + 1, sizeof(double) * (HISTORY_DURATIONS - 1));
+		entry->duration_count--;
+	}
+	entry->durations[entry->duration_count++] = body_ns;
+}
+//	median of `count` values; reorders them
+static double median(double *values, int count)
+{
+	for (int i = 1; i < count; i++)
+	{
+		double value = values[i];
+		int at = i;
+		for (; at > 0 && values[at - 1] > value; at--)
+			values[at] = values[at - 1];
+		values[at] = value;
+	}
+
+	return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+static void history_load(History *history)
+{
+	FILE *in = fopen(history->path, "r");
+	if (!in)
+		return;
+
+	// lines are as long as their names and durations make them
+	char *line = NULL;
+	size_t capacity = 0;
+	int version = 0;
+	if (getline(&line, &capacity, in) > 0)
+	{
+		if (strcmp(line, HISTORY_HEADER) == 0)
+			version = 3;
+		else if (strcmp(line, HISTORY_HEADER_V2) == 0)
+			version = 2;
+		else if (strcmp(line, HISTORY_HEADER_V1) == 0)
+			version = 1;
+	}
+	if (!version)
+	{
+		fwritelnf(stderr, "Warning: %s is not a sigtest history; it will be replaced", history->path);
+		free(line);
+		fclose(in);
+		return;
+	}
+	while (getline(&line, &capacity, in) > 0)
+	{
+		char *set = strtok(line, "\t\n");
+		char *name = strtok(NULL, "\t\n");
+		char *state = strtok(NULL, "\t\n");
+		char *print = strtok(NULL, "\t\n");
+		char *body = strtok(NULL, "\t\n");
+		char *outcomes = version >= 2 ? strtok(NULL, "\t\n") : NULL;
+		char *durations = version >= 3 ? strtok(NULL, "\t\n") : NULL;
+		if (!body || (version >= 2 && !outcomes) || (version >= 3 && !durations))
+			continue;
+
+		int known = -1;
+		for (int each = 0; TEST_STATES[each]; each++)
+		{
+			if (strcmp(TEST_STATES[each], state) == 0)
+				known = each;
+		}
+		if (known < 0)
+			continue;
+
+		HistoryEntry *entry = history_find(history, test_id_hash(set, name), set, name);
+		if (!entry && !(entry = history_add(history, set, name)))
+			break;
+		entry->state = (TestState)known;
+		entry->fingerprint = strtoul(print, NULL, 10);
+		entry->body_ns = atof(body);
+		entry->outcomes[0] = '\0';
+		for (; outcomes && *outcomes; outcomes++)
+		{
+			if (*outcomes == 'P' || *outcomes == 'F')
+				add_outcome(entry, *outcomes);
+		}
+		entry->duration_count = 0;
+		for (char *next = durations; next && *next && *next != '-';)
+		{
+			char *end = NULL;
+			double ns = strtod(next, &end);
+			if (end == next)
+				break;
+			add_duration(entry, ns);
+			next = *end == ',' ? end + 1 : end;
+		}
+	}
+	free(line);
+	fclose(in);
+}
+
+/*
+	Open the result store; a missing file is an empty history
+*/
+History *history_open(const char *path)
+{
+	History *history = calloc(1, sizeof(History));
+	if (!history || !(history->path = strdup(path)))
+	{
+		fwritelnf(stderr, "Error: Failed to allocate the test history");
+		free(history);
+		return NULL;
+	}
+	history_load(history);
+
+	return history;
+}
+/*
+	Rank a case for ordering: 0 failed last time, 1 new or changed, 2 otherwise
+*/
+int history_rank(History *history, TestSet set, TestCase tc)
+{
+	HistoryEntry *entry = history_find(history, tc->id_hash, set->name, tc->name);
+	if (!entry)
+		return HISTORY_CHANGED;
+	if (entry->state == FAIL || entry->state == TIMEOUT || entry->state == CRASH)
+		return HISTORY_FAILED;
+
+	return entry->fingerprint != fingerprint(tc) ? HISTORY_CHANGED : HISTORY_STABLE;
+}
+/*
+	Body time of a case's last run; negative when the store has none
+*/
+double history_duration(History *history, TestSet set, TestCase tc)
+{
+	HistoryEntry *entry = history_find(history, tc->id_hash, set->name, tc->name);
+
+	return entry ? entry->body_ns : -1.0;
+}
+/*
+	Flip rate of a case's recent outcomes; negative until the current body has enough of them
+*/
+double history_flip_rate(History *history, TestSet set, TestCase tc)
+{
+	HistoryEntry *entry = history_find(history, tc->id_hash, set->name, tc->name);
+	size_t length = entry ? strlen(entry->outcomes) : 0;
+	if (length < HISTORY_FLAKY_MIN_RUNS || entry->fingerprint != fingerprint(tc))
+		return -1.0;
+
+	int flips = 0;
+	for (size_t i = 1; i < length; i++)
+		flips += entry->outcomes[i] != entry->outcomes[i - 1];
+
+	return (double)flips / (double)(length - 1);
+}
+//	find or add a reportable case's entry; a changed body starts its outcomes over
+static HistoryEntry *history_entry(History *history, TestSet set, TestCase tc, unsigned long print)
+{
+	// names the line format cannot hold are not kept
+	if (strpbrk(set->name, "\t\n") || strpbrk(tc->name, "\t\n"))
+		return NULL;
+
+	HistoryEntry *entry = history_find(history, tc->id_hash, set->name, tc->name);
+	if (!entry && !(entry = history_add(history, set->name, tc->name)))
+		return NULL;
+	if (entry->fingerprint != print)
+	{
+		entry->outcomes[0] = '\0';
+		entry->duration_count = 0;
+	}
+	entry->fingerprint = print;
+
+	return entry;
+}
+/*
+	Record a reported case's final state
+*/
+void history_record(History *history, TestSet set, TestCase tc)
+{
+	// a case that never ran says nothing new
+	TestState state = tc->test_result.state;
+	HistoryEntry *entry = state == NOT_RUN ? NULL : history_entry(history, set, tc, fingerprint(tc));
+	if (!entry)
+		return;
+	entry->state = state;
+	entry->body_ns = tc->timings[PHASE_BODY].ns;
+	if (state != SKIP)
+		add_outcome(entry, state == PASS ? 'P' : 'F');
+	if (state == PASS)
+		add_duration(entry, tc->timings[PHASE_BODY].ns);
+	history->recorded++;
+}
+/*
+	Baseline body time of a case: the median and median absolute deviation of its recent
+	passes; returns how many there are, 0 when its body changed since
+*/
+int history_baseline(History *history, TestSet set, TestCase tc, double *median_ns, double *mad_ns)
+{
+	HistoryEntry *entry = history_find(history, tc->id_hash, set->name, tc->name);
+	if (!entry || !entry->duration_count || entry->fingerprint != fingerprint(tc))
+		return 0;
+
+	double values[HISTORY_DURATIONS];
+	int count = entry->duration_count;
+	memcpy(values, entry->durations, sizeof(double) * count);
+	*median_ns = median(values, count);
+	for (int i = 0; i < count; i++)
+		values[i] = values[i] > *median_ns ? values[i] - *median_ns : *median_ns - values[i];
+	*mad_ns = median(values, count);
+
+	return count;
+}
+/*
+	Record the failed attempt of a case about to be retried
+*/
+void history_retry(History *history, TestSet set, TestCase tc)
+{
+	HistoryEntry *entry = history_entry(history, set, tc, fingerprint(tc));
+	if (!entry)
+		return;
+	add_outcome(entry, 'F');
+	history->recorded++;
+}
+/*
+	Write the store back when the run recorded anything, then free it
+*/
+void history_close(History *history)
+{
+	if (!history)
+		return;
+
+	if (history->recorded)
+	{
+		size_t length = strlen(history->path) + 8;
+		char *temp = malloc(length);
+		FILE *out = NULL;
+		if (temp)
+		{
+			snprintf(temp, length, "%s.tmp", history->path);
+			out = fopen(temp, "w");
+		}
+		if (!out)
+		{
+			fwritelnf(stderr, "Error: Failed to write test history %s: %s", history->path, strerror(errno));
+		}
+		else
+		{
+			fputs(HISTORY_HEADER, out);
+			for (int i = 0; i < HISTORY_BUCKETS; i++)
+			{
+				for (HistoryEntry *entry = history->buckets[i]; entry; entry = entry->next)
+				{
+					fprintf(out, "%s\t%s\t%s\t%lu\t%.0f\t%s\t", entry->set, entry->name, TEST_STATES[entry->state],
+						  entry->fingerprint, entry->body_ns, *entry->outcomes ? entry->outcomes : "-");
+					for (int d = 0; d < entry->duration_count; d++)
+						fprintf(out, "%s%.0f", d ? "," : "", entry->durations[d]);
+					fprintf(out, "%s\n", entry->duration_count ? "" : "-");
+				}
+			}
+			// the old store stays in place until the new one is complete
+			if (fclose(out) != 0 || rename(temp, history->path) != 0)
+			{
+				fwritelnf(stderr, "Error: Failed to write test history %s: %s", history->path, strerror(errno));
+				remove(temp);
+			}
+		}
+		free(temp);
+	}
+	for (int i = 0; i < HISTORY_BUCKETS; i++)
+	{
+		for (HistoryEntry *entry = history->buckets[i], *next; entry; entry = next)
+		{
+			next = entry->next;
+			free(entry->set);
+			free(entry->name);
+			free(entry);
+		}
+	}
+	free(history->path);
+	free(history);
+}
@@ -0,0 +1,388 @@
+/*	src/sigtest_internal.h
+	Runner machinery shared by the library sources, the bundled hooks and the tests
+
+	Not installed: the result ring, the completion journal, the result store, duration
+	trends, the status line, test selection and the repeat workers are implementation
+	details of `run_tests`, free to change between releases.
+*/
+#ifndef SIGTEST_INTERNAL_H
+#define SIGTEST_INTERNAL_H
+
+#include "sigtest.h"
+
+// Fork worker result ring: slots per worker and the longest message a slot carries
+#define RESULT_RING_SLOTS 8
+#define RESULT_MESSAGE_MAX 1024
+typedef enum
+{
+	SLOT_EMPTY,
+	SLOT_OPEN, /* Case started; the result is not written yet */
+	SLOT_DONE, /* Result published */
+} SlotState;
+typedef struct
+{
+	SlotState commit; /* Stored last; readers must load it with acquire ordering */
+	int index;			/* Case index within the set */
+	TestState state;
+	int message_len;
+	ts_tick started; /* Case start in the worker */
+	PhaseTiming timings[PHASE_COUNT];
+	char message[RESULT_MESSAGE_MAX];
+} ResultSlot;
+typedef struct ResultRing ResultRing;
+
+/**
+ * @brief Create a single-producer result ring in shared memory; workers forked later share it
+ * @return the ring, or NULL on error
+ */
+ResultRing *ring_create(void);
+/**
+ * @brief Empty a ring for a fresh worker
+ * @param ring :the result ring
+ */
+void ring_reset(ResultRing *ring);
+/**
+ * @brief Unmap a result ring
+ * @param ring :the result ring
+ */
+void ring_destroy(ResultRing *ring);
+/**
+ * @brief Worker side: claim the next slot for a starting case and mark it open
+ * @param ring :the result ring
+ * @param index :the case index
+ * @return the claimed slot, or NULL when the ring is full
+ */
+ResultSlot *ring_open(ResultRing *ring, int index);
+/**
+ * @brief Worker side: copy a case's result into its slot and publish it
+ * @param slot :the slot claimed for the case
+ * @param tc :the finished test case
+ */
+void ring_commit(ResultSlot *slot, TestCase tc);
+/**
+ * @brief Runner side: peek at the oldest claimed slot
+ * @param ring :the result ring
+ * @param commit :receives the slot's state, SLOT_OPEN or SLOT_DONE
+ * @return the slot, or NULL when the ring is empty
+ */
+ResultSlot *ring_front(ResultRing *ring, SlotState *commit);
+/**
+ * @brief Runner side: free the oldest claimed slot
+ * @param ring :the result ring
+ */
+void ring_release(ResultRing *ring);
+
+// Completion journal: cases appended between fsyncs, and the file used by a bare `--resume`
+#define JOURNAL_SYNC_EVERY 64
+#define SIGTEST_JOURNAL_DEFAULT ".sigtest.journal"
+typedef struct Journal Journal;
+
+/**
+ * @brief Open the completion journal
+ * @param path :the journal file
+ * @param resume :load the cases completed by earlier runs and append to them; otherwise truncate
+ * @return the journal, or NULL on error
+ */
+Journal *journal_open(const char *path, int resume);
+/**
+ * @brief Append a completed case, with the state its body produced
+ * @param journal :the journal
+ * @param set :the test set
+ * @param tc :the completed test case
+ */
+void journal_append(Journal *journal, TestSet set, TestCase tc);
+/**
+ * @brief Restore a case's result and body time from an earlier run
+ * @param journal :the journal
+ * @param set :the test set
+ * @param tc :the test case
+ * @return TRUE when the case was journaled, else FALSE
+ */
+int journal_restore(Journal *journal, TestSet set, TestCase tc);
+/**
+ * @brief Number of cases restored from earlier runs
+ * @param journal :the journal
+ */
+int journal_restored(Journal *journal);
+/**
+ * @brief Flush appended cases to stable storage
+ * @param journal :the journal
+ */
+void journal_sync(Journal *journal);
+/**
+ * @brief Sync and close the journal
+ * @param journal :the journal
+ */
+void journal_close(Journal *journal);
+
+// Result store for test ordering: the file used by a bare `--order=failed-first`, and case ranks
+#define SIGTEST_HISTORY_DEFAULT ".sigtest.history"
+#define HISTORY_FAILED 0	/* Failed, timed out or crashed on its last run */
+#define HISTORY_CHANGED 1 /* Not in the store, or its body changed since */
+#define HISTORY_STABLE 2
+// Flakiness: outcomes kept per case, the fewest a flip rate is computed from, and the default quarantine rate
+#define HISTORY_WINDOW 32
+#define HISTORY_FLAKY_MIN_RUNS 5
+#define HISTORY_FLAKY_RATE 0.2
+// Duration trend: passing body times kept per case
+#define HISTORY_DURATIONS 16
+typedef struct History History;
+
+/**
+ * @brief Open the persistent result store
+ * @param path :the history file; a missing file is an empty history
+ * @return the history, or NULL on error
+ */
+History *history_open(const char *path);
+/**
+ * @brief Rank a test case for ordering by its previous outcome
+ * @param history :the history
+ * @param set :the test set
+ * @param tc :the test case
+ * @return HISTORY_FAILED, HISTORY_CHANGED or HISTORY_STABLE
+ */
+int history_rank(History *history, TestSet set, TestCase tc);
+/**
+ * @brief Body time of a case's last run
+ * @param history :the history
+ * @param set :the test set
+ * @param tc :the test case
+ * @return the body time in nanoseconds, or a negative value when unknown
+ */
+double history_duration(History *history, TestSet set, TestCase tc);
+/**
+ * @brief Record a reported case's final state
+ * @param history :the history
+ * @param set :the test set
+ * @param tc :the reported test case
+ */
+void history_record(History *history, TestSet set, TestCase tc);
+/**
+ * @brief Record the failed attempt of a test case that is about to be retried
+ * @param history :the history
+ * @param set :the test set
+ * @param tc :the failed test case
+ */
+void history_retry(History *history, TestSet set, TestCase tc);
+/**
+ * @brief Flakiness of a test case: the share of its recent outcomes that differ from the one before
+ * @param history :the history
+ * @param set :the test set
+ * @param tc :the test case
+ * @return the flip rate, or a negative value until its current body has HISTORY_FLAKY_MIN_RUNS outcomes
+ */
+double history_flip_rate(History *history, TestSet set, TestCase tc);
+/**
+ * @brief Baseline body time of a test case from its recent passes
+ * @param history :the history
+ * @param set :the test set
+ * @param tc :the test case
+ * @param median_ns :receives the median body time
+ * @param mad_ns :receives the median absolute deviation of the body times
+ * @return the number of passes the baseline is taken from; 0 when there are none for its current body
+ */
+int history_baseline(History *history, TestSet set, TestCase tc, double *median_ns, double *mad_ns);
+/**
+ * @brief Write the updated store and close the history
+ * @param history :the history
+ */
+void history_close(History *history);
+
+// Duration trend: passes a baseline needs, MADs and nanoseconds a slowdown must clear, and the defaults
+#define TREND_MIN_RUNS 5
+#define TREND_NOISE_MADS 3.0
+#define TREND_MIN_DELTA_NS 1000.0
+#define TREND_SLOWDOWN 2.0
+#define TREND_TOP 10
+typedef struct Trend Trend;
+
+/**
+ * @brief Start a duration trend report
+ * @param slowdown :the ratio to the baseline median past which a case has regressed
+ * @param top :the number of slowest cases to list
+ * @return the trend, or NULL on error
+ */
+Trend *trend_open(double slowdown, int top);
+/**
+ * @brief Compare a reported case's durations with its baseline; call before it is recorded in the history
+ * @param trend :the trend
+ * @param history :the history holding the baseline
+ * @param set :the test set
+ * @param tc :the reported test case
+ */
+void trend_record(Trend *trend, History *history, TestSet set, TestCase tc);
+/**
+ * @brief Write the regressions, the slowest cases and the set totals
+ * @param trend :the trend
+ * @param path :the report file; stdout when NULL
+ * @return the number of regressed cases
+ */
+int trend_report(Trend *trend, const char *path);
+/**
+ * @brief Free a trend
+ * @param trend :the trend
+ */
+void trend_close(Trend *trend);
+
+// Live progress: status line frames per second
+#define PROGRESS_HZ 4
+typedef struct Progress Progress;
+
+/**
+ * @brief Weigh the cases about to run by their history and start the status line thread
+ * @param sets :the sets to run, in run order
+ * @param count :the number of sets
+ * @param history :the result store to weigh cases by; NULL reads SIGTEST_HISTORY
+ * @param fd :the terminal the line is drawn on
+ * @return the progress, or NULL on error
+ */
+Progress *progress_start(TestSet *sets, int count, History *history, int fd);
+/**
+ * @brief Show the set now running
+ * @param progress :the progress
+ * @param set :the set
+ */
+void progress_set(Progress *progress, TestSet set);
+/**
+ * @brief Count a reported case; call before it is recorded in the history
+ * @param progress :the progress
+ * @param set :the test set
+ * @param tc :the reported test case
+ */
+void progress_done(Progress *progress, TestSet set, TestCase tc);
+/**
+ * @brief Show the number of busy fork workers
+ * @param progress :the progress
+ * @param active :the workers
+ */
+void progress_workers(Progress *progress, int active);
+/**
+ * @brief Erase the status line and draw no frame until released
+ * @param progress :the progress
+ */
+void progress_hold(Progress *progress);
+/**
+ * @brief Let the status line draw again after a hold
+ * @param progress :the progress
+ */
+void progress_release(Progress *progress);
+/**
+ * @brief Stop the status line thread, erase the line and free the progress
+ * @param progress :the progress
+ */
+void progress_stop(Progress *progress);
+
+// Test selection: `set/case` globs and `re:` regexes; a leading `-` excludes
+typedef struct Filter Filter;
+
+/**
+ * @brief Compile a comma-separated list of filter patterns
+ * @param spec :the patterns, e.g. `math,-math/slow_*,re:^io/.*_v2$`
+ * @return the filter, or NULL when a pattern is invalid
+ */
+Filter *filter_compile(const char *spec);
+/**
+ * @brief Check whether a test case is selected
+ * @param filter :the compiled filter
+ * @param set :the test set name
+ * @param name :the test case name
+ * @return TRUE when the case is selected, else FALSE
+ */
+int filter_match(Filter *filter, const char *set, const char *name);
+/**
+ * @brief Free a compiled filter
+ * @param filter :the filter
+ */
+void filter_free(Filter *filter);
+
+// Tag selection expressions
+typedef struct TagExpr TagExpr;
+
+/**
+ * @brief Compile a tag selection expression of tags, `!`, `&`, `|` (or `,`) and parentheses
+ * @param text :the expression, e.g. "fast & !flaky"
+ * @return the compiled selection, or NULL when it does not parse
+ */
+TagExpr *tag_expr_compile(const char *text);
+/**
+ * @brief Check a case's tags against a compiled selection
+ * @param expr :the compiled selection
+ * @param tags :the case's tags
+ * @return TRUE when the tags are selected, else FALSE
+ */
+int tag_expr_match(TagExpr *expr, TagMask tags);
+/**
+ * @brief Free a compiled selection
+ * @param expr :the compiled selection
+ */
+void tag_expr_free(TagExpr *expr);
+
+/**
+ * @brief Write the selected registry as a JSON or binary manifest without running anything
+ * @param sets :the test set registry
+ * @param filter :the name filter; NULL selects every name
+ * @param tags :the tag selection; NULL selects every case
+ * @param format :"json" or "binary"
+ * @param path :the manifest file; stdout when NULL or empty
+ * @return EXIT_SUCCESS, or EXIT_FAILURE when the manifest could not be written
+ */
+int sigtest_list(TestSet sets, Filter *filter, TagExpr *tags, const char *format, const char *path);
+
+// Repeat modes on forked workers
+/**
+ * @brief A forked repeat worker's share of the runs; shared with the runner
+ */
+typedef struct
+{
+	RepeatStats stats;			 /* Runs completed by the slot's workers */
+	int running;					 /* A run is under way; stored with release ordering */
+	unsigned long long current; /* Its run number */
+	ts_tick started;				 /* Its start */
+} RepeatSlot;
+/**
+ * @brief Shared state of a case repeated on forked workers
+ */
+typedef struct
+{
+	unsigned long long claimed; /* Run numbers handed out across the workers */
+	int stop;						 /* An until-fail run found its failure */
+	int slots;
+	RepeatSlot slot[];
+} RepeatShared;
+
+/**
+ * @brief Record one run of a repeated case
+ * @param stats :the case's repeat stats
+ * @param run :the run number, from 1
+ * @param state :the state the run ended in
+ * @param body_ns :the run's body time
+ * @param failed :TRUE when the run broke the case's expectation
+ * @param message :the run's message; may be NULL
+ */
+void repeat_record(RepeatStats *stats, unsigned long long run, TestState state, double body_ns, int failed,
+						 const char *message);
+/**
+ * @brief Add the runs of one repeat stats to another
+ * @param into :the stats added to
+ * @param from :the stats added
+ */
+void repeat_merge(RepeatStats *into, const RepeatStats *from);
+/**
+ * @brief Parse a repeat duration: a number with an optional `ms`, `s`, `m` or `h` unit (seconds by default)
+ * @param text :the duration, e.g. "90s" or "2m"
+ * @return the duration in milliseconds, or a negative value when it does not parse
+ */
+double repeat_duration_ms(const char *text);
+/**
+ * @brief Map the shared state for a case repeated on forked workers
+ * @param slots :the number of workers
+ * @return the shared state, or NULL on error
+ */
+RepeatShared *repeat_shared_create(int slots);
+/**
+ * @brief Unmap the shared state of a repeated case
+ * @param shared :the shared state
+ */
+void repeat_shared_destroy(RepeatShared *shared);
+
+#endif // SIGTEST_INTERNAL_H
@@ -0,0 +1,271 @@
+/*
+	sigtest_journal.c
+	Append-only completion journal
+
+	The runner appends one line per completed case: set, case, state, body nanoseconds and
+	message, tab separated, with tabs, newlines and backslashes escaped. The state is the
+	one the body produced, before expectations are applied, so a replayed case goes through
+	the same result processing as a fresh one. Each line is a single write() on an O_APPEND
+	descriptor, so nothing is lost when the process dies; the journal is fsynced every
+	JOURNAL_SYNC_EVERY cases and when a set ends, which bounds what a lost host costs. When
+	resuming, a trailing line without its newline was torn by the crash and is ignored.
+*/
+#include "sigtest_internal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define JOURNAL_HEADER "# sigtest journal v1\n"
+#define JOURNAL_BUCKETS 1024
+#define JOURNAL_LINE_MAX 4096
+
+typedef struct JournalEntry
+{
+	struct JournalEntry *next; /* Next in the bucket */
+	char *set;
+	char *name;
+	TestState state;
+	double body_ns;
+	char *message; /* NULL when the case had none */
+} JournalEntry;
+
+struct Journal
+{
+	int fd;
+	int unsynced;	/* Lines appended since the last fsync */
+	int restored;	/* Cases replayed from the journal */
+	JournalEntry *buckets[JOURNAL_BUCKETS];
+};
+
+static JournalEntry *journal_find(Journal *journal, unsigned int hash, const char *set, const char *name)
+{
+	for (JournalEntry *entry = journal->buckets[hash % JOURNAL_BUCKETS]; entry; entry = entry->next)
+	{
+		if (strcmp(entry->set, set) == 0 && strcmp(entry->name, name) == 0)
+			return entry;
+	}
+
+	return NULL;
+}
+static size_t escape_field(char *out, size_t size, const char *field)
+{
+	size_t used = 0;
+	for (; field && *field && used + 2 < size; field++)
+	{
+		char c = *field;
+		if (c == '\t' || c == '\n' || c == '\\')
+		{
+			out[used++] = '\\';
+			c = c == '\t' ? 't' : c == '\n' ? 'n'
+														: '\\';
+		}
+		out[used++] = c;
+	}
+	out[used] = '\0';
+
+	return used;
+}
+//	unescape a field in place and return the start of the next one
+static char *next_field(char *field)
+{
+	char *out = field;
+	for (char *in = field; *in; in++)
+	{
+		if (*in == '\t')
+		{
+			*out = '\0';
+			return in + 1;
+		}
+		if (*in == '\\' && in[1])
+		{
+			in++;
+			*out++ = *in == 't' ? '\t' : *in == 'n' ? '\n'
+																 : *in;
+			continue;
+		}
+		*out++ = *in;
+	}
+	*out = '\0';
+
+	return NULL;
+}
+static TestState state_named(const char *name, int *known)
+{
+	for (int state = 0; TEST_STATES[state]; state++)
+	{
+		if (strcmp(TEST_STATES[state], name) == 0)
+		{
+			*known = TRUE;
+			return (TestState)state;
+		}
+	}
+	*known = FALSE;
+
+	return FAIL;
+}
+static void journal_load(Journal *journal, const char *path)
+{
+	FILE *in = fopen(path, "r");
+	if (!in)
+		return;
+
+	char line[JOURNAL_LINE_MAX];
+	if (!fgets(line, sizeof(line), in) || strcmp(line, JOURNAL_HEADER) != 0)
+	{
+		fwritelnf(stderr, "Warning: %s is not a sigtest journal; nothing to resume", path);
+		fclose(in);
+		return;
+	}
+	while (fgets(line, sizeof(line), in))
+	{
+		size_t length = strlen(line);
+		if (!length || line[length - 1] != '\n')
+			continue; // torn by the crash, or too long to be ours
+		line[length - 1] = '\0';
+
+		char *set = line;
+		char *name = next_field(set);
+		char *state = name ? next_field(name) : NULL;
+		char *body = state ? next_field(state) : NULL;
+		char *message = body ? next_field(body) : NULL;
+		int known = FALSE;
+		TestState parsed = state ? state_named(state, &known) : FAIL;
+		if (!message || !known)
+			continue;
+
+		// a case journaled twice keeps its latest result
+		JournalEntry *entry = journal_find(journal, test_id_hash(set, name), set, name);
+		if (!entry)
+		{
+			entry = calloc(1, sizeof(JournalEntry));
+			if (!entry)
+				break;
+			entry->set = strdup(set);
+			entry->name = strdup(name);
+			uint32_t bucket = test_id_hash(set, name) % JOURNAL_BUCKETS;
+			entry->next = journal->buckets[bucket];
+			journal->buckets[bucket] = entry;
+		}
+		free(entry->message);
+		entry->state = parsed;
+		entry->body_ns = atof(body);
+		entry->message = *message ? strdup(message) : NULL;
+	}
+	fclose(in);
+}
+
+/*
+	Open the journal; resuming loads the completed cases and keeps appending to it
+*/
+Journal *journal_open(const char *path, int resume)
+{
+	Journal *journal = calloc(1, sizeof(Journal));
+	if (!journal)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate the journal");
+		return NULL;
+	}
+	journal->fd = -1;
+	if (resume)
+		journal_load(journal, path);
+
+	struct stat st;
+	int fresh = !resume || stat(path, &st) != 0 || st.st_size == 0;
+	journal->fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC | (resume ? 0 : O_TRUNC), 0644);
+	if (journal->fd < 0)
+	{
+		fwritelnf(stderr, "Error: Failed to open journal %s: %s", path, strerror(errno));
+		journal_close(journal);
+		return NULL;
+	}
+	char last = '\n';
+	if (fresh && write(journal->fd, JOURNAL_HEADER, strlen(JOURNAL_HEADER)) < 0)
+	{
+		fwritelnf(stderr, "Error: Failed to write journal %s: %s", path, strerror(errno));
+	}
+	else if (!fresh && pread(journal->fd, &last, 1, st.st_size - 1) == 1 && last != '\n')
+	{
+		// end the torn line so the next case starts a line of its own
+		if (write(journal->fd, "\n", 1) < 0)
+			fwritelnf(stderr, "Error: Failed to write journal %s: %s", path, strerror(errno));
+	}
+
+	return journal;
+}
+/*
+	Append a completed case; `tc` still holds the state its body produced
+*/
+void journal_append(Journal *journal, TestSet set, TestCase tc)
+{
+	char line[JOURNAL_LINE_MAX];
+	size_t used = escape_field(line, sizeof(line) / 4, set->name);
+	line[used++] = '\t';
+	used += escape_field(line + used, sizeof(line) / 4, tc->name);
+	used += snprintf(line + used, sizeof(line) - used, "\t%s\t%.0f\t", TEST_STATES[tc->test_result.state],
+						  tc->timings[PHASE_BODY].ns);
+	used += escape_field(line + used, sizeof(line) - used - 1, tc->test_result.message);
+	line[used++] = '\n';
+
+	// one write per line; O_APPEND keeps the line whole
+	if (write(journal->fd, line, used) < 0)
+		return;
+	if (++journal->unsynced >= JOURNAL_SYNC_EVERY)
+		journal_sync(journal);
+}
+/*
+	Replay a case completed by an earlier run; returns TRUE when it was journaled
+*/
+int journal_restore(Journal *journal, TestSet set, TestCase tc)
+{
+	JournalEntry *entry = journal_find(journal, tc->id_hash, set->name, tc->name);
+	if (!entry)
+		return FALSE;
+
+	tc->test_result.state = entry->state;
+	if (tc->test_result.message)
+		free(tc->test_result.message);
+	tc->test_result.message = entry->message ? strdup(entry->message) : NULL;
+	memset(tc->timings, 0, sizeof(tc->timings));
+	tc->timings[PHASE_BODY].ns = entry->body_ns;
+	journal->restored++;
+
+	return TRUE;
+}
+int journal_restored(Journal *journal)
+{
+	return journal->restored;
+}
+void journal_sync(Journal *journal)
+{
+	if (!journal->unsynced)
+		return;
+
+	fdatasync(journal->fd);
+	journal->unsynced = 0;
+}
+void journal_close(Journal *journal)
+{
+	if (!journal)
+		return;
+
+	if (journal->fd >= 0)
+	{
+		journal_sync(journal);
+		close(journal->fd);
+	}
+	for (int i = 0; i < JOURNAL_BUCKETS; i++)
+	{
+		for (JournalEntry *entry = journal->buckets[i], *next; entry; entry = next)
+		{
+			next = entry->next;
+			free(entry->set);
+			free(entry->name);
+			free(entry->message);
+			free(entry);
+		}
+	}
+	free(journal);
+}
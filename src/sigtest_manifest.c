@@ -0,0 +1,158 @@
+/*
+	sigtest_manifest.c
+	Test manifest export
+
+	List mode writes the selected registry without running anything: no set config, no
+	hooks, no clock calibration. Each case is listed with its stable id (`set/case` and
+	its test_id_hash), set, tags, expectation, timeout and, when the result store has run
+	it before, its last body time as the expected duration.
+
+	The JSON manifest is a single document with one object per case. The binary manifest
+	uses the binary result stream framing (see `include/hooks/binary_hooks.h`) with one
+	REC_MANIFEST_CASE record per case.
+*/
+#include "sigtest_internal.h"
+#include "hooks/binary_hooks.h"
+#include <stdlib.h>
+#include <string.h>
+
+static void write_json_str(FILE *out, const char *str)
+{
+	fputc('"', out);
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			fputc('\\', out);
+		fputc((unsigned char)*str < 0x20 ? ' ' : *str, out);
+	}
+	fputc('"', out);
+}
+static void put_uint(FILE *out, uint64_t value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		fputc((int)((value >> (i * 8)) & 0xff), out);
+}
+static void put_str(FILE *out, const char *str)
+{
+	size_t length = strlen(str);
+	if (length > 0xffff)
+		length = 0xffff;
+	put_uint(out, length, 2);
+	fwrite(str, 1, length, out);
+}
+
+static void list_json(FILE *out, TestSet set, TestCase tc, int first, double expected_ns)
+{
+	char id[1024], tags[512];
+	snprintf(id, sizeof(id), "%s/%s", set->name, tc->name);
+	tag_names(tc->tags, tags, sizeof(tags));
+
+	fprintf(out, "%s\n  {\"id\": ", first ? "" : ",");
+	write_json_str(out, id);
+	fprintf(out, ", \"hash\": %u, \"set\": ", tc->id_hash);
+	write_json_str(out, set->name);
+	fprintf(out, ", \"case\": ");
+	write_json_str(out, tc->name);
+	fprintf(out, ", \"tags\": [");
+	char *next = NULL;
+	for (char *tag = strtok_r(tags, ",", &next); tag; tag = strtok_r(NULL, ",", &next))
+	{
+		fprintf(out, "%s", tag == tags ? "" : ", ");
+		write_json_str(out, tag);
+	}
+	const char *expect = tc->expect_fail ? "fail" : "pass";
+	if (tc->expect_throw)
+		expect = "throw";
+	fprintf(out, "], \"expect\": \"%s\"", expect);
+	double timeout_ms = tc->timeout_ms > 0.0 ? tc->timeout_ms : set->timeout_ms;
+	fprintf(out, ", \"timeout_ms\": %.3f, \"isolated\": %s", timeout_ms, set->fork_batch > 0 ? "true" : "false");
+	if (expected_ns >= 0.0)
+		fprintf(out, ", \"expected_us\": %.3f}", expected_ns / 1000.0);
+	else
+		fprintf(out, ", \"expected_us\": null}");
+}
+static void list_binary(FILE *out, TestSet set, TestCase tc, double expected_ns)
+{
+	char tags[512];
+	tag_names(tc->tags, tags, sizeof(tags));
+	uint8_t flags = (tc->expect_fail ? REC_FLAG_EXPECT_FAIL : 0) | (tc->expect_throw ? REC_FLAG_EXPECT_THROW : 0) |
+						 (set->fork_batch > 0 ? REC_FLAG_ISOLATED : 0) | (expected_ns >= 0.0 ? REC_FLAG_HAS_HISTORY : 0);
+	double timeout_ms = tc->timeout_ms > 0.0 ? tc->timeout_ms : set->timeout_ms;
+	size_t set_length = strlen(set->name), name_length = strlen(tc->name);
+
+	put_uint(out, REC_MANIFEST_CASE, 1);
+	put_uint(out, 4 + 1 + 8 + 8 + 6 + (set_length > 0xffff ? 0xffff : set_length) +
+						  (name_length > 0xffff ? 0xffff : name_length) + strlen(tags),
+				4);
+	put_uint(out, tc->id_hash, 4);
+	put_uint(out, flags, 1);
+	put_uint(out, (uint64_t)(timeout_ms * 1000000.0), 8);
+	put_uint(out, expected_ns >= 0.0 ? (uint64_t)expected_ns : 0, 8);
+	put_str(out, set->name);
+	put_str(out, tc->name);
+	put_str(out, tags);
+}
+
+/*
+	Write the selected registry as a manifest and run nothing
+*/
+int sigtest_list(TestSet sets, Filter *filter, TagExpr *tags, const char *format, const char *path)
+{
+	int binary = strcmp(format, "binary") == 0;
+	if (!binary && strcmp(format, "json") != 0 && strcmp(format, "1") != 0)
+	{
+		fwritelnf(stderr, "Error: Unknown manifest format '%s' (json|binary)", format);
+		return EXIT_FAILURE;
+	}
+	FILE *out = path && *path ? fopen(path, binary ? "wb" : "w") : stdout;
+	if (!out)
+	{
+		fwritelnf(stderr, "Error: Failed to open manifest %s", path);
+		return EXIT_FAILURE;
+	}
+	// expected durations come from the result store when there is one; it is only read
+	const char *store = getenv("SIGTEST_HISTORY");
+	History *history = history_open(store && *store ? store : SIGTEST_HISTORY_DEFAULT);
+
+	if (binary)
+	{
+		fwrite(BINARY_STREAM_MAGIC, 1, 4, out);
+		put_uint(out, BINARY_STREAM_VERSION, 2);
+		put_uint(out, 0, 2);
+	}
+	else
+	{
+		fprintf(out, "{\"version\": 1, \"tests\": [");
+	}
+	int listed = 0;
+	for (TestSet set = sets; set; set = set->next)
+	{
+		for (TestCase tc = set->cases; tc; tc = tc->next)
+		{
+			if ((filter && !filter_match(filter, set->name, tc->name)) || (tags && !tag_expr_match(tags, tc->tags)))
+				continue;
+			double expected_ns = history ? history_duration(history, set, tc) : -1.0;
+			if (binary)
+				list_binary(out, set, tc, expected_ns);
+			else
+				list_json(out, set, tc, !listed, expected_ns);
+			listed++;
+		}
+	}
+	if (!binary)
+		fprintf(out, "%s]}\n", listed ? "\n" : "");
+
+	history_close(history);
+	int failed = ferror(out);
+	if (out != stdout)
+		failed |= fclose(out) != 0;
+	else
+		fflush(out);
+	if (failed)
+	{
+		fwritelnf(stderr, "Error: Failed to write manifest %s", path ? path : "to stdout");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
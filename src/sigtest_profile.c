@@ -0,0 +1,284 @@
+/*
+	sigtest_profile.c
+	SIGPROF sampling profiler
+
+	An ITIMER_PROF timer raises SIGPROF while the runner burns CPU; the signal is process
+	directed, so every other runner thread keeps it blocked. The handler walks the
+	frame-pointer chain of the interrupted test body (bounded by the runner's own frame)
+	into a preallocated sample table, tagged with the executing test case; it never
+	allocates, locks or calls into stdio. Samples of cases that finish under the duration
+	threshold are dropped when the case ends. On stop, samples are symbolized with dladdr
+	and written as folded stacks (`set;case;frame;...;leaf count`) for flame graph tools.
+*/
+#define _GNU_SOURCE
+#include "sigtest.h"
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+
+#define PROFILE_MAX_DEPTH 32
+#define PROFILE_MAX_SAMPLES 16384
+#define PROFILE_DEFAULT_HZ 997	 // prime, so sampling does not beat with periodic work
+#define PROFILE_STACK_LIMIT (8 << 20) // largest stack distance the unwinder will walk
+
+typedef struct
+{
+	TestSet set;
+	TestCase tc;
+	int depth;
+	void *pcs[PROFILE_MAX_DEPTH]; /* Leaf first */
+} ProfileSample;
+
+static struct
+{
+	int active;
+	char *path;				 /* Folded stack output */
+	double threshold_ns;	 /* Keep samples of cases at least this long */
+	ProfileSample *samples;
+	int case_first;		 /* First sample of the running case */
+	struct sigaction previous;
+} profile = {0};
+
+// shared with the signal handler
+static volatile sig_atomic_t sample_count = 0;
+static volatile sig_atomic_t sample_dropped = 0; // samples lost to a full table
+static TestSet volatile profile_set = NULL;
+static TestCase volatile profile_case = NULL;
+static uintptr_t volatile profile_top = 0;
+
+static void profile_handler(int sig, siginfo_t *info, void *ucontext)
+{
+	(void)sig;
+	(void)info;
+	int saved_errno = errno;
+
+	TestCase tc = profile_case;
+	uintptr_t top = profile_top;
+	if (!tc || sample_count >= PROFILE_MAX_SAMPLES)
+	{
+		if (tc)
+			sample_dropped++;
+		errno = saved_errno;
+		return;
+	}
+
+	ucontext_t *uc = ucontext;
+	ProfileSample *sample = &profile.samples[sample_count];
+	int depth = 0;
+#if defined(__x86_64__)
+	uintptr_t pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+	uintptr_t sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+	uintptr_t fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__aarch64__)
+	uintptr_t pc = (uintptr_t)uc->uc_mcontext.pc;
+	uintptr_t sp = (uintptr_t)uc->uc_mcontext.sp;
+	uintptr_t fp = (uintptr_t)uc->uc_mcontext.regs[29];
+#else
+	uintptr_t pc = 0, sp = 0, fp = 0;
+#endif
+	if (pc)
+		sample->pcs[depth++] = (void *)pc;
+	// every frame must sit between the interrupted stack pointer and the runner's frame
+	while (depth < PROFILE_MAX_DEPTH && fp >= sp && fp < top && top - sp < PROFILE_STACK_LIMIT &&
+			 !(fp & (sizeof(uintptr_t) - 1)))
+	{
+		uintptr_t *frame = (uintptr_t *)fp;
+		if (!frame[1])
+			break;
+		sample->pcs[depth++] = (void *)frame[1];
+		if (frame[0] <= fp)
+			break;
+		fp = frame[0];
+	}
+	sample->depth = depth;
+	sample->set = profile_set;
+	sample->tc = tc;
+	sample_count++;
+
+	errno = saved_errno;
+}
+
+/*
+	Start the sampling profiler
+*/
+int profile_start(const char *path, int hz, double threshold_us)
+{
+	if (profile.active)
+		return 0;
+	if (!path)
+	{
+		fwritelnf(stderr, "Error: Profiler needs an output path");
+		return -1;
+	}
+
+	profile.samples = malloc(sizeof(ProfileSample) * PROFILE_MAX_SAMPLES);
+	profile.path = strdup(path);
+	if (!profile.samples || !profile.path)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate profiler sample table");
+		free(profile.samples);
+		free(profile.path);
+		profile.samples = NULL;
+		profile.path = NULL;
+		return -1;
+	}
+	profile.threshold_ns = threshold_us > 0.0 ? threshold_us * 1000.0 : 0.0;
+	profile.case_first = 0;
+	sample_dropped = 0;
+	sample_count = 0;
+
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_sigaction = profile_handler;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGPROF, &action, &profile.previous) != 0)
+	{
+		fwritelnf(stderr, "Error: Failed to install SIGPROF handler: %s", strerror(errno));
+		return -1;
+	}
+
+	if (hz <= 0)
+		hz = PROFILE_DEFAULT_HZ;
+	struct itimerval timer;
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = hz >= 1000000 ? 1 : 1000000 / hz;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL) != 0)
+	{
+		fwritelnf(stderr, "Error: Failed to start profiling timer: %s", strerror(errno));
+		sigaction(SIGPROF, &profile.previous, NULL);
+		return -1;
+	}
+	profile.active = TRUE;
+
+	return 0;
+}
+/*
+	Start and stop attributing samples to a test case
+*/
+void profile_enter_case(TestSet set, TestCase tc, void *top)
+{
+	if (!profile.active)
+		return;
+
+	profile.case_first = sample_count;
+	profile_top = (uintptr_t)top;
+	profile_set = set;
+	profile_case = tc;
+}
+void profile_leave_case(double elapsed_ns)
+{
+	if (!profile.active)
+		return;
+
+	profile_case = NULL;
+	// the progress thread blocks SIGPROF, so the handler runs on this thread and the case's samples are contiguous
+	if (elapsed_ns < profile.threshold_ns)
+		sample_count = profile.case_first;
+}
+
+//	name a frame; static functions only resolve when the executable exports its symbols
+static void frame_name(void *pc, char *buffer, size_t size)
+{
+	Dl_info info;
+	memset(&info, 0, sizeof(info));
+	if (dladdr(pc, &info) && info.dli_sname)
+	{
+		snprintf(buffer, size, "%s", info.dli_sname);
+	}
+	else if (info.dli_fname)
+	{
+		const char *module = strrchr(info.dli_fname, '/');
+		snprintf(buffer, size, "%s+0x%lx", module ? module + 1 : info.dli_fname,
+					(unsigned long)((uintptr_t)pc - (uintptr_t)info.dli_fbase));
+	}
+	else
+	{
+		snprintf(buffer, size, "0x%lx", (unsigned long)(uintptr_t)pc);
+	}
+}
+static int compare_lines(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/*
+	Stop the profiler and write folded stacks
+*/
+void profile_stop(void)
+{
+	if (!profile.active)
+		return;
+
+	struct itimerval timer = {{0, 0}, {0, 0}};
+	setitimer(ITIMER_PROF, &timer, NULL);
+	sigaction(SIGPROF, &profile.previous, NULL);
+	profile.active = FALSE;
+	profile_case = NULL;
+
+	int count = sample_count;
+	char **lines = calloc(count ? count : 1, sizeof(char *));
+	FILE *out = fopen(profile.path, "w");
+	if (!lines || !out)
+	{
+		fwritelnf(stderr, "Error: Failed to write profile %s", profile.path);
+		if (out)
+			fclose(out);
+	}
+	else
+	{
+		// one line per sample, root first
+		for (int i = 0; i < count; i++)
+		{
+			ProfileSample *sample = &profile.samples[i];
+			size_t size = 256 + (size_t)sample->depth * 128;
+			char *line = malloc(size);
+			if (!line)
+				break;
+			int used = snprintf(line, size, "%s;%s", sample->set ? sample->set->name : "", sample->tc->name);
+			for (int depth = sample->depth - 1; depth >= 0 && used < (int)size; depth--)
+			{
+				// return addresses point past the call; step back into it
+				char *pc = (char *)sample->pcs[depth] - (depth ? 1 : 0);
+				char name[128];
+				frame_name(pc, name, sizeof(name));
+				used += snprintf(line + used, size - used, ";%s", name);
+			}
+			lines[i] = line;
+		}
+
+		// identical stacks collapse into one counted line
+		int total = 0;
+		while (total < count && lines[total])
+			total++;
+		qsort(lines, total, sizeof(char *), compare_lines);
+		for (int i = 0; i < total;)
+		{
+			int run = 1;
+			while (i + run < total && strcmp(lines[i], lines[i + run]) == 0)
+				run++;
+			fprintf(out, "%s %d\n", lines[i], run);
+			i += run;
+		}
+		fclose(out);
+		for (int i = 0; i < total; i++)
+			free(lines[i]);
+	}
+	if (sample_dropped)
+	{
+		fwritelnf(stderr, "Warning: Profiler dropped %d samples; the sample table is full", (int)sample_dropped);
+	}
+
+	free(lines);
+	free(profile.samples);
+	free(profile.path);
+	profile.samples = NULL;
+	profile.path = NULL;
+}
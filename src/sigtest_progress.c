@@ -0,0 +1,244 @@
+/*
+	sigtest_progress.c
+	Live progress status line
+
+	`--progress` keeps one status line on the terminal while the run goes on: cases done of
+	the total, failures, busy fork workers, the running set and an estimate of the time left.
+	A thread redraws it PROGRESS_HZ times a second with a single write(); the runner only
+	bumps counters as cases are reported, so the hot path gains neither a syscall nor a flush.
+	The runner turns it on only when stderr is a terminal, and holds it for the whole of a set
+	whose log is a terminal too, as its per-case lines would land on the status line.
+
+	The estimate weighs every case by its last body time in the result store (a case the store
+	has not seen weighs the mean of those it has; with no store at all every case weighs the
+	same) and scales the weight left by the time the weight done has taken so far. Setup,
+	hooks and workers are accounted for by that scaling rather than modelled.
+*/
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+// case weight when the store knows no case at all
+#define PROGRESS_UNIT_NS 1000000.0
+
+struct Progress
+{
+	int fd;
+	History *history;	 /* Store the weights are read from */
+	History *owned;	 /* The store, when progress opened it */
+	double mean_ns;	 /* Weight of a case the store has not seen */
+	double total_ns;	 /* Weight of the whole run */
+	int total;
+	int sets;
+	ts_tick start;
+	pthread_t thread;
+	pthread_mutex_t lock; /* Held while the line is drawn, or by the runner to keep it off */
+	pthread_cond_t wake;
+	int stop;
+	// written by the runner, read by the thread
+	int done;
+	int failed;
+	int workers;
+	int set_index;
+	TestSet set;
+	unsigned long long done_ns; /* Weight of the cases done */
+};
+
+static double case_weight(Progress *progress, TestSet set, TestCase tc)
+{
+	double expected_ns = progress->history ? history_duration(progress->history, set, tc) : -1.0;
+
+	return expected_ns >= 0.0 ? expected_ns : progress->mean_ns;
+}
+//	format a duration as `1h02m`, `3m07s` or `12s`
+static void format_eta(char *buffer, size_t size, double seconds)
+{
+	unsigned long whole = (unsigned long)(seconds + 0.5);
+	if (whole >= 3600)
+		snprintf(buffer, size, "%luh%02lum", whole / 3600, whole / 60 % 60);
+	else if (whole >= 60)
+		snprintf(buffer, size, "%lum%02lus", whole / 60, whole % 60);
+	else
+		snprintf(buffer, size, "%lus", whole);
+}
+//	draw the line; the caller holds the lock
+static void draw(Progress *progress)
+{
+	int done = __atomic_load_n(&progress->done, __ATOMIC_RELAXED);
+	int failed = __atomic_load_n(&progress->failed, __ATOMIC_RELAXED);
+	int workers = __atomic_load_n(&progress->workers, __ATOMIC_RELAXED);
+	int set_index = __atomic_load_n(&progress->set_index, __ATOMIC_RELAXED);
+	TestSet set = __atomic_load_n(&progress->set, __ATOMIC_ACQUIRE);
+	double done_ns = (double)__atomic_load_n(&progress->done_ns, __ATOMIC_RELAXED);
+	double elapsed_s = get_elapsed_ns(progress->start, sys_getticks()) / 1e9;
+
+	char eta[32] = "--";
+	if (done_ns > 0.0)
+	{
+		double left_ns = progress->total_ns > done_ns ? progress->total_ns - done_ns : 0.0;
+		format_eta(eta, sizeof(eta), elapsed_s * left_ns / done_ns);
+	}
+	char line[256];
+	int length = snprintf(line, sizeof(line), "\r\033[K[%d/%d] %d failed", done, progress->total, failed);
+	if (workers)
+		length += snprintf(line + length, sizeof(line) - length, ", %d workers", workers);
+	if (set)
+		length += snprintf(line + length, sizeof(line) - length, "  set %d/%d %.40s", set_index, progress->sets, set->name);
+	length += snprintf(line + length, sizeof(line) - length, "  ETA %s", eta);
+	if (length >= (int)sizeof(line))
+		length = sizeof(line) - 1;
+
+	// a frame the terminal cannot take now is dropped; the next one draws the line again
+	ssize_t written = write(progress->fd, line, length);
+	(void)written;
+}
+static void erase(Progress *progress)
+{
+	ssize_t written = write(progress->fd, "\r\033[K", 4);
+	(void)written;
+}
+static void *progress_main(void *arg)
+{
+	Progress *progress = arg;
+	pthread_mutex_lock(&progress->lock);
+	while (!progress->stop)
+	{
+		draw(progress);
+		struct timespec until;
+		clock_gettime(CLOCK_REALTIME, &until);
+		until.tv_nsec += 1000000000L / PROGRESS_HZ;
+		if (until.tv_nsec >= 1000000000L)
+		{
+			until.tv_sec++;
+			until.tv_nsec -= 1000000000L;
+		}
+		while (!progress->stop && pthread_cond_timedwait(&progress->wake, &progress->lock, &until) == 0)
+			;
+	}
+	pthread_mutex_unlock(&progress->lock);
+
+	return NULL;
+}
+
+/*
+	Weigh the cases of the sets about to run and start drawing their progress
+*/
+Progress *progress_start(TestSet *sets, int count, History *history, int fd)
+{
+	Progress *progress = calloc(1, sizeof(Progress));
+	if (!progress)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate progress");
+		return NULL;
+	}
+	progress->fd = fd;
+	progress->sets = count;
+	progress->history = history;
+	if (!history)
+	{
+		// the store is only read; nothing is recorded to it
+		const char *store = getenv("SIGTEST_HISTORY");
+		progress->history = progress->owned = history_open(store && *store ? store : SIGTEST_HISTORY_DEFAULT);
+	}
+
+	double known_ns = 0.0;
+	int known = 0;
+	for (int i = 0; i < count; i++)
+	{
+		for (TestCase tc = sets[i]->cases; tc; tc = tc->next)
+		{
+			double expected_ns = progress->history ? history_duration(progress->history, sets[i], tc) : -1.0;
+			progress->total++;
+			if (expected_ns < 0.0)
+				continue;
+			known_ns += expected_ns;
+			known++;
+		}
+	}
+	progress->mean_ns = known ? known_ns / known : PROGRESS_UNIT_NS;
+	progress->total_ns = known_ns + progress->mean_ns * (progress->total - known);
+	progress->start = sys_getticks();
+
+	pthread_mutex_init(&progress->lock, NULL);
+	pthread_cond_init(&progress->wake, NULL);
+	// the thread takes no signals: the profiler's process-directed SIGPROF, the timeout and crash
+	// signals and interrupts all belong to the runner thread; it inherits the mask it starts with
+	sigset_t blocked, previous;
+	sigfillset(&blocked);
+	pthread_sigmask(SIG_BLOCK, &blocked, &previous);
+	int started = pthread_create(&progress->thread, NULL, progress_main, progress);
+	pthread_sigmask(SIG_SETMASK, &previous, NULL);
+	if (started != 0)
+	{
+		fwritelnf(stderr, "Warning: Failed to start the progress thread; running without a status line");
+		pthread_mutex_destroy(&progress->lock);
+		pthread_cond_destroy(&progress->wake);
+		history_close(progress->owned);
+		free(progress);
+		return NULL;
+	}
+
+	return progress;
+}
+/*
+	Show the set now running
+*/
+void progress_set(Progress *progress, TestSet set)
+{
+	__atomic_add_fetch(&progress->set_index, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&progress->set, set, __ATOMIC_RELEASE);
+}
+/*
+	Count a reported case; call before it is recorded in the history
+*/
+void progress_done(Progress *progress, TestSet set, TestCase tc)
+{
+	TestState state = tc->test_result.state;
+	__atomic_add_fetch(&progress->done_ns, (unsigned long long)case_weight(progress, set, tc), __ATOMIC_RELAXED);
+	if (state == FAIL || state == TIMEOUT || state == CRASH)
+		__atomic_add_fetch(&progress->failed, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&progress->done, 1, __ATOMIC_RELAXED);
+}
+/*
+	Show the number of busy fork workers
+*/
+void progress_workers(Progress *progress, int active)
+{
+	__atomic_store_n(&progress->workers, active, __ATOMIC_RELAXED);
+}
+/*
+	Erase the line and draw no frame until released, while the runner writes to the terminal
+*/
+void progress_hold(Progress *progress)
+{
+	pthread_mutex_lock(&progress->lock);
+	erase(progress);
+}
+void progress_release(Progress *progress)
+{
+	pthread_mutex_unlock(&progress->lock);
+}
+/*
+	Stop the thread and erase the line
+*/
+void progress_stop(Progress *progress)
+{
+	if (!progress)
+		return;
+
+	pthread_mutex_lock(&progress->lock);
+	progress->stop = TRUE;
+	pthread_cond_signal(&progress->wake);
+	pthread_mutex_unlock(&progress->lock);
+	pthread_join(progress->thread, NULL);
+	erase(progress);
+
+	pthread_mutex_destroy(&progress->lock);
+	pthread_cond_destroy(&progress->wake);
+	history_close(progress->owned);
+	free(progress);
+}
@@ -0,0 +1,147 @@
+/*
+	sigtest_repeat.c
+	Repeat and stress modes
+
+	`--repeat=<n>`, `--repeat-for=<duration>` and `--until-fail` run each selected case many
+	times and report it once, with the counts of how its runs ended and a histogram of their
+	body times. The histogram has one bucket per power of two nanoseconds, so recording a run
+	is a count-leading-zeros and an increment however many runs there are, and stats from
+	several workers merge by adding buckets. Percentiles read from it are bucket upper bounds:
+	within a factor of two, which is what a flaky or slow run stands out by.
+
+	Repeated on forked workers, every worker owns a RepeatSlot in an anonymous shared mapping
+	and claims run numbers from a shared counter. The runner reads a slot's in-flight run to
+	blame it when the worker dies or overruns, and merges the slots when the case is done.
+*/
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+//	bucket of a body time: the bit length of its nanoseconds
+static int bucket_of(double ns)
+{
+	unsigned long long whole = ns < 1.0 ? 0 : (unsigned long long)ns;
+	int bucket = whole ? 64 - __builtin_clzll(whole) : 0;
+
+	return bucket < REPEAT_BUCKETS ? bucket : REPEAT_BUCKETS - 1;
+}
+
+/*
+	Record one run of a repeated case
+*/
+void repeat_record(RepeatStats *stats, unsigned long long run, TestState state, double body_ns, int failed,
+						 const char *message)
+{
+	if (!stats->runs || body_ns < stats->min_ns)
+		stats->min_ns = body_ns;
+	if (body_ns > stats->max_ns)
+		stats->max_ns = body_ns;
+	stats->total_ns += body_ns;
+	stats->histogram[bucket_of(body_ns)]++;
+	stats->runs++;
+	if (state < NOT_RUN)
+		stats->states[state]++;
+	if (!failed)
+		return;
+
+	stats->failures++;
+	// workers finish out of order; the earliest run number is the first failure
+	if (!stats->first_failure || run < stats->first_failure)
+	{
+		stats->first_failure = run;
+		stats->failure = state;
+		snprintf(stats->message, sizeof(stats->message), "%s", message ? message : "");
+	}
+}
+/*
+	Add the runs of one repeat stats to another
+*/
+void repeat_merge(RepeatStats *into, const RepeatStats *from)
+{
+	if (!from->runs)
+		return;
+
+	if (!into->runs || from->min_ns < into->min_ns)
+		into->min_ns = from->min_ns;
+	if (from->max_ns > into->max_ns)
+		into->max_ns = from->max_ns;
+	into->total_ns += from->total_ns;
+	into->runs += from->runs;
+	into->failures += from->failures;
+	for (int state = 0; state < NOT_RUN; state++)
+		into->states[state] += from->states[state];
+	for (int bucket = 0; bucket < REPEAT_BUCKETS; bucket++)
+		into->histogram[bucket] += from->histogram[bucket];
+	if (from->first_failure && (!into->first_failure || from->first_failure < into->first_failure))
+	{
+		into->first_failure = from->first_failure;
+		into->failure = from->failure;
+		memcpy(into->message, from->message, sizeof(into->message));
+	}
+}
+/*
+	Estimate a body time percentile from the histogram
+*/
+double repeat_percentile(const RepeatStats *stats, double fraction)
+{
+	if (!stats->runs)
+		return 0.0;
+
+	unsigned long long rank = (unsigned long long)(fraction * stats->runs + 0.5), seen = 0;
+	rank = rank ? rank : 1;
+	for (int bucket = 0; bucket < REPEAT_BUCKETS; bucket++)
+	{
+		seen += stats->histogram[bucket];
+		if (seen < rank)
+			continue;
+		double upper = (double)(1ULL << bucket);
+		return upper < stats->max_ns ? upper : stats->max_ns;
+	}
+
+	return stats->max_ns;
+}
+/*
+	Parse a repeat duration; seconds unless a unit says otherwise
+*/
+double repeat_duration_ms(const char *text)
+{
+	char *unit = NULL;
+	double value = strtod(text, &unit);
+	if (unit == text || value < 0.0)
+		return -1.0;
+	if (!*unit || strcmp(unit, "s") == 0)
+		return value * 1000.0;
+	if (strcmp(unit, "ms") == 0)
+		return value;
+	if (strcmp(unit, "m") == 0)
+		return value * 60000.0;
+	if (strcmp(unit, "h") == 0)
+		return value * 3600000.0;
+
+	return -1.0;
+}
+/*
+	Map the shared state for a case repeated on forked workers
+*/
+RepeatShared *repeat_shared_create(int slots)
+{
+	size_t size = sizeof(RepeatShared) + sizeof(RepeatSlot) * slots;
+	RepeatShared *shared = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (shared == MAP_FAILED)
+	{
+		fwritelnf(stderr, "Error: Failed to map repeat workers: %s", strerror(errno));
+		return NULL;
+	}
+	// anonymous mappings start zeroed
+	shared->slots = slots;
+
+	return shared;
+}
+void repeat_shared_destroy(RepeatShared *shared)
+{
+	if (shared)
+		munmap(shared, sizeof(RepeatShared) + sizeof(RepeatSlot) * shared->slots);
+}
@@ -0,0 +1,120 @@
+/*
+	sigtest_ring.c
+	Shared-memory result ring between a fork worker and the runner
+
+	Each ring is a memfd mapping created by the runner before the worker is forked, so both
+	processes see the same pages. The worker is the only producer: it claims the next slot
+	when a case starts (SLOT_OPEN, with the case index and start tick), fills in the result
+	in place and publishes it by storing SLOT_DONE last, with release ordering. The runner is
+	the only consumer and frees slots in order. A worker that dies mid-case leaves its slot
+	open, which is how the runner tells a partial record from a finished one.
+*/
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+struct ResultRing
+{
+	uint64_t head; /* Slots claimed by the worker */
+	uint64_t tail; /* Slots released by the runner */
+	ResultSlot slots[RESULT_RING_SLOTS];
+};
+
+/*
+	Create a ring shared with workers forked afterwards
+*/
+ResultRing *ring_create(void)
+{
+	int fd = memfd_create("sigtest-results", MFD_CLOEXEC);
+	if (fd < 0)
+	{
+		fwritelnf(stderr, "Error: Failed to create result ring: %s", strerror(errno));
+		return NULL;
+	}
+	ResultRing *ring = MAP_FAILED;
+	if (ftruncate(fd, sizeof(ResultRing)) == 0)
+		ring = mmap(NULL, sizeof(ResultRing), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	// the mapping keeps the memory alive
+	close(fd);
+	if (ring == MAP_FAILED)
+	{
+		fwritelnf(stderr, "Error: Failed to map result ring: %s", strerror(errno));
+		return NULL;
+	}
+
+	return ring;
+}
+/*
+	Empty a ring for a fresh worker; no worker may be attached
+*/
+void ring_reset(ResultRing *ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	for (int i = 0; i < RESULT_RING_SLOTS; i++)
+		ring->slots[i].commit = SLOT_EMPTY;
+}
+void ring_destroy(ResultRing *ring)
+{
+	if (ring)
+		munmap(ring, sizeof(ResultRing));
+}
+/*
+	Worker side: claim the next slot for a starting case
+*/
+ResultSlot *ring_open(ResultRing *ring, int index)
+{
+	uint64_t head = ring->head;
+	if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == RESULT_RING_SLOTS)
+		return NULL;
+
+	ResultSlot *slot = &ring->slots[head % RESULT_RING_SLOTS];
+	slot->index = index;
+	slot->state = PASS;
+	slot->message_len = 0;
+	slot->started = sys_getticks();
+	__atomic_store_n(&slot->commit, SLOT_OPEN, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+	return slot;
+}
+/*
+	Worker side: publish a filled slot
+*/
+void ring_commit(ResultSlot *slot, TestCase tc)
+{
+	slot->state = tc->test_result.state;
+	memcpy(slot->timings, tc->timings, sizeof(slot->timings));
+	slot->message_len = tc->test_result.message ? (int)strnlen(tc->test_result.message, RESULT_MESSAGE_MAX - 1) : 0;
+	memcpy(slot->message, tc->test_result.message ? tc->test_result.message : "", slot->message_len);
+	slot->message[slot->message_len] = '\0';
+	__atomic_store_n(&slot->commit, SLOT_DONE, __ATOMIC_RELEASE);
+}
+/*
+	Runner side: the oldest claimed slot, open or done; NULL when the ring is empty
+*/
+ResultSlot *ring_front(ResultRing *ring, SlotState *commit)
+{
+	uint64_t tail = ring->tail;
+	if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+		return NULL;
+
+	ResultSlot *slot = &ring->slots[tail % RESULT_RING_SLOTS];
+	// pairs with the worker's release; the slot's fields are visible once it is seen done
+	*commit = __atomic_load_n(&slot->commit, __ATOMIC_ACQUIRE);
+
+	return slot;
+}
+/*
+	Runner side: free the oldest slot
+*/
+void ring_release(ResultRing *ring)
+{
+	ResultSlot *slot = &ring->slots[ring->tail % RESULT_RING_SLOTS];
+	slot->commit = SLOT_EMPTY;
+	__atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
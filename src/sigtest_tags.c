@@ -0,0 +1,262 @@
+/*
+	sigtest_tags.c
+	Test tags and tag selection
+
+	Tag names are interned into a table of SIGTEST_MAX_TAGS entries as they are registered;
+	each case carries a TagMask with one bit per tag, its set's tags included. A selection
+	expression (`fast & !flaky`, `(db | io) & nightly`) is compiled once into a postfix
+	program over those bits, so selecting a case is a handful of mask tests on a small stack.
+*/
+#include "sigtest_internal.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+static char tag_table[SIGTEST_MAX_TAGS][SIGTEST_TAG_MAX];
+static int tag_count = 0;
+
+typedef enum
+{
+	OP_TAG, /* Push whether the case has the tag */
+	OP_NOT,
+	OP_AND,
+	OP_OR,
+} TagOp;
+
+typedef struct
+{
+	TagOp op;
+	TagMask mask; /* OP_TAG only */
+} TagInstr;
+
+struct TagExpr
+{
+	int count;
+	int depth; /* Deepest the evaluation stack gets */
+	TagInstr *program;
+};
+
+// parser state over an expression; emits the program as it goes
+typedef struct
+{
+	const char *at;
+	TagExpr *expr;
+	int depth;
+	int error;
+} TagParser;
+
+static int is_tag_char(char c)
+{
+	return isalnum((unsigned char)c) || c == '_' || c == '-' || c == '.' || c == ':';
+}
+//	index of a tag name; registering adds names not yet seen
+static int tag_index(const char *name, size_t length, int create)
+{
+	for (int i = 0; i < tag_count; i++)
+	{
+		if (strlen(tag_table[i]) == length && strncmp(tag_table[i], name, length) == 0)
+			return i;
+	}
+	if (!create)
+		return -1;
+	if (tag_count == SIGTEST_MAX_TAGS || length >= SIGTEST_TAG_MAX)
+	{
+		fwritelnf(stderr, "Warning: Tag '%.*s' ignored; tags are limited to %d names of %d characters",
+					 (int)length, name, SIGTEST_MAX_TAGS, SIGTEST_TAG_MAX - 1);
+		return -1;
+	}
+	memcpy(tag_table[tag_count], name, length);
+	tag_table[tag_count][length] = '\0';
+
+	return tag_count++;
+}
+
+/*
+	Register a comma-separated list of tags and return their mask
+*/
+TagMask tag_mask(const char *tags)
+{
+	TagMask mask = 0;
+	for (const char *at = tags; at && *at;)
+	{
+		while (*at == ',' || isspace((unsigned char)*at))
+			at++;
+		const char *start = at;
+		while (*at && *at != ',' && !isspace((unsigned char)*at))
+			at++;
+		if (at == start)
+			continue;
+		// a name the selection parser cannot read could never be selected
+		const char *end = start;
+		while (end < at && is_tag_char(*end))
+			end++;
+		if (end < at)
+		{
+			fwritelnf(stderr, "Warning: Tag '%.*s' ignored; tag names take letters, digits, '_', '-', '.' and ':'",
+						 (int)(at - start), start);
+			continue;
+		}
+		int index = tag_index(start, at - start, TRUE);
+		if (index >= 0)
+			mask |= 1ULL << index;
+	}
+
+	return mask;
+}
+/*
+	Write the names in a tag mask, comma-separated; returns the length written
+*/
+int tag_names(TagMask tags, char *buffer, size_t size)
+{
+	int used = 0;
+	if (size)
+		buffer[0] = '\0';
+	for (int i = 0; i < tag_count && used < (int)size; i++)
+	{
+		if (tags & (1ULL << i))
+			used += snprintf(buffer + used, size - used, "%s%s", used ? "," : "", tag_table[i]);
+	}
+
+	return used < (int)size ? used : (int)size - 1;
+}
+
+static void emit(TagParser *parser, TagOp op, TagMask mask, int push)
+{
+	TagExpr *expr = parser->expr;
+	expr->program[expr->count].op = op;
+	expr->program[expr->count].mask = mask;
+	expr->count++;
+	parser->depth += push;
+	if (parser->depth > expr->depth)
+		expr->depth = parser->depth;
+}
+static void skip_space(TagParser *parser)
+{
+	while (isspace((unsigned char)*parser->at))
+		parser->at++;
+}
+static void parse_or(TagParser *parser);
+static void parse_unary(TagParser *parser)
+{
+	skip_space(parser);
+	if (*parser->at == '!')
+	{
+		parser->at++;
+		parse_unary(parser);
+		emit(parser, OP_NOT, 0, 0);
+	}
+	else if (*parser->at == '(')
+	{
+		parser->at++;
+		parse_or(parser);
+		skip_space(parser);
+		if (*parser->at != ')')
+		{
+			parser->error = TRUE;
+			return;
+		}
+		parser->at++;
+	}
+	else if (is_tag_char(*parser->at))
+	{
+		const char *start = parser->at;
+		while (is_tag_char(*parser->at))
+			parser->at++;
+		int index = tag_index(start, parser->at - start, FALSE);
+		if (index < 0)
+			fwritelnf(stderr, "Warning: No test is tagged '%.*s'", (int)(parser->at - start), start);
+		emit(parser, OP_TAG, index < 0 ? 0 : 1ULL << index, 1);
+	}
+	else
+	{
+		parser->error = TRUE;
+	}
+}
+static void parse_and(TagParser *parser)
+{
+	parse_unary(parser);
+	for (skip_space(parser); !parser->error && *parser->at == '&'; skip_space(parser))
+	{
+		parser->at++;
+		parse_unary(parser);
+		emit(parser, OP_AND, 0, -1);
+	}
+}
+static void parse_or(TagParser *parser)
+{
+	parse_and(parser);
+	for (skip_space(parser); !parser->error && (*parser->at == '|' || *parser->at == ','); skip_space(parser))
+	{
+		parser->at++;
+		parse_and(parser);
+		emit(parser, OP_OR, 0, -1);
+	}
+}
+
+/*
+	Compile a tag selection expression; NULL when it does not parse
+*/
+TagExpr *tag_expr_compile(const char *text)
+{
+	TagExpr *expr = calloc(1, sizeof(TagExpr));
+	// every character emits at most one instruction
+	if (expr)
+		expr->program = malloc(sizeof(TagInstr) * (strlen(text) + 1));
+	if (!expr || !expr->program)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate tag selection");
+		tag_expr_free(expr);
+		return NULL;
+	}
+
+	TagParser parser = {text, expr, 0, FALSE};
+	parse_or(&parser);
+	skip_space(&parser);
+	if (parser.error || *parser.at)
+	{
+		fwritelnf(stderr, "Error: Invalid tag selection '%s' at '%s'", text, parser.at);
+		tag_expr_free(expr);
+		return NULL;
+	}
+
+	return expr;
+}
+/*
+	Evaluate a compiled selection against a case's tags
+*/
+int tag_expr_match(TagExpr *expr, TagMask tags)
+{
+	int stack[expr->depth + 1];
+	int top = 0;
+	for (int i = 0; i < expr->count; i++)
+	{
+		TagInstr *instr = &expr->program[i];
+		switch (instr->op)
+		{
+		case OP_TAG:
+			stack[top++] = (tags & instr->mask) != 0;
+			break;
+		case OP_NOT:
+			stack[top - 1] = !stack[top - 1];
+			break;
+		case OP_AND:
+			top--;
+			stack[top - 1] = stack[top - 1] && stack[top];
+			break;
+		case OP_OR:
+			top--;
+			stack[top - 1] = stack[top - 1] || stack[top];
+			break;
+		}
+	}
+
+	return top ? stack[top - 1] : TRUE;
+}
+void tag_expr_free(TagExpr *expr)
+{
+	if (!expr)
+		return;
+
+	free(expr->program);
+	free(expr);
+}
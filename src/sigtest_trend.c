@@ -0,0 +1,195 @@
+/*
+	sigtest_trend.c
+	Duration trend reports
+
+	`--trend` compares every reported case's body time with its baseline in the result store,
+	the median of its last HISTORY_DURATIONS passes. A case has regressed when it passed but
+	ran over `--slowdown` times its median, and the slowdown clears the noise: at least
+	TREND_NOISE_MADS median absolute deviations and TREND_MIN_DELTA_NS over the median. A
+	baseline of fewer than TREND_MIN_RUNS passes is too thin to judge and is only shown.
+
+	The medians cover body time only; a regression is listed with its setup and teardown
+	times from the current run, so a slow fixture can be told from a slow body. The report
+	also lists the slowest cases of the run and every set's total against the total of its
+	cases' medians.
+*/
+#include "sigtest_internal.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+	TestSet set;
+	TestCase tc;
+	double body_ns, setup_ns, teardown_ns;
+	double median_ns, mad_ns; /* Baseline; valid when samples > 0 */
+	int samples;
+	int regressed;
+} TrendCase;
+
+struct Trend
+{
+	double slowdown;
+	int top;
+	int count;
+	int capacity;
+	int regressions;
+	TrendCase *cases;
+};
+
+/*
+	Start a duration trend report
+*/
+Trend *trend_open(double slowdown, int top)
+{
+	Trend *trend = calloc(1, sizeof(Trend));
+	if (!trend)
+	{
+		fwritelnf(stderr, "Error: Failed to allocate duration trend");
+		return NULL;
+	}
+	trend->slowdown = slowdown > 1.0 ? slowdown : TREND_SLOWDOWN;
+	trend->top = top >= 0 ? top : TREND_TOP;
+
+	return trend;
+}
+/*
+	Compare a reported case with its baseline
+*/
+void trend_record(Trend *trend, History *history, TestSet set, TestCase tc)
+{
+	if (tc->test_result.state == NOT_RUN)
+		return;
+	if (trend->count == trend->capacity)
+	{
+		int capacity = trend->capacity ? trend->capacity * 2 : 64;
+		TrendCase *cases = realloc(trend->cases, sizeof(TrendCase) * capacity);
+		if (!cases)
+		{
+			fwritelnf(stderr, "Warning: Duration trend dropped %s/%s; out of memory", set->name, tc->name);
+			return;
+		}
+		trend->cases = cases;
+		trend->capacity = capacity;
+	}
+
+	TrendCase *entry = &trend->cases[trend->count++];
+	memset(entry, 0, sizeof(TrendCase));
+	entry->set = set;
+	entry->tc = tc;
+	entry->body_ns = tc->timings[PHASE_BODY].ns;
+	entry->setup_ns = tc->timings[PHASE_SETUP].ns;
+	entry->teardown_ns = tc->timings[PHASE_TEARDOWN].ns;
+	entry->samples = history ? history_baseline(history, set, tc, &entry->median_ns, &entry->mad_ns) : 0;
+	if (tc->test_result.state != PASS || entry->samples < TREND_MIN_RUNS)
+		return;
+
+	double delta = entry->body_ns - entry->median_ns;
+	if (entry->body_ns > entry->median_ns * trend->slowdown && delta > entry->mad_ns * TREND_NOISE_MADS &&
+		 delta >= TREND_MIN_DELTA_NS)
+	{
+		entry->regressed = TRUE;
+		trend->regressions++;
+	}
+}
+
+//	slowest body first
+static int by_body(const void *left, const void *right)
+{
+	const TrendCase *a = *(const TrendCase *const *)left, *b = *(const TrendCase *const *)right;
+
+	return (a->body_ns < b->body_ns) - (a->body_ns > b->body_ns);
+}
+static void write_case(FILE *out, TrendCase *entry)
+{
+	char id[512];
+	snprintf(id, sizeof(id), "%s/%s", entry->set->name, entry->tc->name);
+	fprintf(out, "  %-48s %12.3f us", id, entry->body_ns / 1000.0);
+	if (entry->samples)
+		fprintf(out, "  median %12.3f us  %6.2fx", entry->median_ns / 1000.0,
+				  entry->median_ns > 0.0 ? entry->body_ns / entry->median_ns : 0.0);
+	fputc('\n', out);
+}
+
+/*
+	Write the regressions, the slowest cases and the set totals; returns the regressions
+*/
+int trend_report(Trend *trend, const char *path)
+{
+	FILE *out = path && *path ? fopen(path, "w") : stdout;
+	if (!out)
+	{
+		fwritelnf(stderr, "Error: Failed to open duration trend %s", path);
+		return trend->regressions;
+	}
+
+	fprintf(out, "Duration trend: %d cases against the median of their last %d passes\n", trend->count,
+			  HISTORY_DURATIONS);
+	fprintf(out, "Regressions (over %.2fx the median, %.0f MADs and %.3f us):\n", trend->slowdown, TREND_NOISE_MADS,
+			  TREND_MIN_DELTA_NS / 1000.0);
+	for (int i = 0; i < trend->count; i++)
+	{
+		TrendCase *entry = &trend->cases[i];
+		if (!entry->regressed)
+			continue;
+		write_case(out, entry);
+		fprintf(out, "  %-48s setup %.3f us, teardown %.3f us, %d passes, MAD %.3f us\n", "", entry->setup_ns / 1000.0,
+				  entry->teardown_ns / 1000.0, entry->samples, entry->mad_ns / 1000.0);
+	}
+	if (!trend->regressions)
+		fprintf(out, "  none\n");
+
+	int top = trend->top < trend->count ? trend->top : trend->count;
+	TrendCase **sorted = top ? malloc(sizeof(TrendCase *) * trend->count) : NULL;
+	if (sorted)
+	{
+		for (int i = 0; i < trend->count; i++)
+			sorted[i] = &trend->cases[i];
+		qsort(sorted, trend->count, sizeof(TrendCase *), by_body);
+		fprintf(out, "Slowest %d cases:\n", top);
+		for (int i = 0; i < top; i++)
+			write_case(out, sorted[i]);
+		free(sorted);
+	}
+
+	// cases are reported set by set, so each set's cases are contiguous
+	fprintf(out, "Set totals (cases with a baseline against their medians):\n");
+	for (int i = 0; i < trend->count;)
+	{
+		TestSet set = trend->cases[i].set;
+		double total = 0.0, known = 0.0, baseline = 0.0;
+		int cases = 0, baselined = 0;
+		for (; i < trend->count && trend->cases[i].set == set; i++, cases++)
+		{
+			total += trend->cases[i].body_ns;
+			if (!trend->cases[i].samples)
+				continue;
+			known += trend->cases[i].body_ns;
+			baseline += trend->cases[i].median_ns;
+			baselined++;
+		}
+		fprintf(out, "  %-48s %12.3f us  %d cases", set->name, total / 1000.0, cases);
+		if (baselined)
+			fprintf(out, "; %d: %.3f us, median %.3f us, %.2fx", baselined, known / 1000.0, baseline / 1000.0,
+					  baseline > 0.0 ? known / baseline : 0.0);
+		fputc('\n', out);
+	}
+
+	int failed = ferror(out);
+	if (out != stdout)
+		failed |= fclose(out) != 0;
+	else
+		fflush(out);
+	if (failed)
+		fwritelnf(stderr, "Error: Failed to write duration trend %s", path ? path : "to stdout");
+
+	return trend->regressions;
+}
+void trend_close(Trend *trend)
+{
+	if (!trend)
+		return;
+
+	free(trend->cases);
+	free(trend);
+}
@@ -0,0 +1,72 @@
+// test_batch.c
+#include "sigtest.h"
+
+/*
+ * Test case for batched result delivery: a reporter with only `on_results_batch`
+ * receives completed cases in batches of `batch_size`.
+ */
+struct BatchContext
+{
+	int batches;
+	int delivered;
+};
+
+static struct BatchContext batch_ctx = {0, 0};
+
+static void set_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_batch.log", "w");
+}
+static void batch_on_results(const TestSet set, const TestCase *cases, int count, object context)
+{
+	struct BatchContext *ctx = context;
+	ctx->batches++;
+	ctx->delivered += count;
+	for (int i = 0; i < count; i++)
+	{
+		set->logger->log("Batch %d: %-36s [%s]\n", ctx->batches, cases[i]->name,
+							  cases[i]->test_result.state == PASS ? "PASS" : "FAIL");
+	}
+}
+static struct sigtest_hooks_s batch_hooks = {
+	 .name = "batch_hooks",
+	 .on_results_batch = batch_on_results,
+	 .batch_size = 2,
+	 .context = &batch_ctx,
+};
+
+//	test cases
+static void test_first(void)
+{
+	Assert.isTrue(batch_ctx.batches == 0, "No batch expected yet, got %d", batch_ctx.batches);
+}
+static void test_second(void)
+{
+	Assert.isTrue(batch_ctx.delivered == 0, "No results expected yet, got %d", batch_ctx.delivered);
+}
+static void test_third(void)
+{
+	Assert.isTrue(batch_ctx.batches == 1, "One batch expected, got %d", batch_ctx.batches);
+	Assert.isTrue(batch_ctx.delivered == 2, "Two results expected, got %d", batch_ctx.delivered);
+}
+static void test_fourth(void)
+{
+	Assert.isTrue(batch_ctx.delivered == 2, "Third result should still be pending, got %d", batch_ctx.delivered);
+}
+static void test_fifth(void)
+{
+	Assert.isTrue(batch_ctx.batches == 2, "Two batches expected, got %d", batch_ctx.batches);
+}
+
+// Register test cases
+__attribute__((constructor)) void init_batch_tests(void)
+{
+	testset("batch_set", set_config, NULL);
+	register_hooks(&batch_hooks);
+
+	testcase("first", test_first);
+	testcase("second", test_second);
+	testcase("third", test_third);
+	testcase("fourth", test_fourth);
+	testcase("fifth", test_fifth);
+}
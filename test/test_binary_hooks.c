@@ -0,0 +1,336 @@
+// test_binary_hooks.c
+#include "hooks/binary_hooks.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test case for the binary result stream hooks; convert the output with
+ * `bin/sigconvert -f json logs/test_binary_hooks.bin`.
+ *
+ * Two sets log their streams to their own files; the check set, which runs last, converts
+ * each stream and both concatenated into one, and parses what `sigconvert` writes.
+ */
+#define SIGCONVERT "bin/sigconvert"
+#define BINARY_LOG "logs/test_binary_hooks.bin"
+#define BINARY_MORE_LOG "logs/test_binary_hooks_more.bin"
+#define BINARY_ALL_LOG "logs/test_binary_hooks_all.bin"
+
+static void set_config(FILE **log_stream)
+{
+	// initialize the log stream
+	*log_stream = fopen(BINARY_LOG, "wb");
+}
+static void more_config(FILE **log_stream)
+{
+	*log_stream = fopen(BINARY_MORE_LOG, "wb");
+}
+static void check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_binary_hooks_check.bin", "wb");
+}
+
+static char *read_file(const char *path, long *size)
+{
+	FILE *in = fopen(path, "rb");
+	if (!in)
+		return NULL;
+	fseek(in, 0, SEEK_END);
+	*size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+	char *data = calloc(1, *size + 1);
+	if (data && fread(data, 1, *size, in) != (size_t)*size)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(in);
+
+	return data;
+}
+// run sigconvert over a stream and return what it wrote, or NULL when it failed
+static char *convert(const char *format, const char *path)
+{
+	char command[256];
+	snprintf(command, sizeof(command), SIGCONVERT " -f %s %s", format, path);
+	FILE *pipe = popen(command, "r");
+	if (!pipe)
+		return NULL;
+
+	size_t used = 0, size = 4096;
+	char *text = malloc(size);
+	size_t got;
+	while (text && (got = fread(text + used, 1, size - used - 1, pipe)) > 0)
+	{
+		used += got;
+		if (size - used < 2)
+			text = realloc(text, size *= 2);
+	}
+	if (pclose(pipe) != 0 || !text)
+	{
+		free(text);
+		return NULL;
+	}
+	text[used] = '\0';
+
+	return text;
+}
+
+//	a minimal JSON reader: each returns the end of the value at `p`, or NULL when it is malformed
+static const char *json_string(const char *p)
+{
+	if (*p++ != '"')
+		return NULL;
+	for (; *p != '"'; p++)
+	{
+		if ((unsigned char)*p < 0x20)
+			return NULL;
+		if (*p == '\\')
+		{
+			p++;
+			if (*p == 'u')
+			{
+				for (int i = 1; i <= 4; i++)
+					if (!isxdigit((unsigned char)p[i]))
+						return NULL;
+				p += 4;
+			}
+			else if (!*p || !strchr("\"\\/bfnrt", *p))
+				return NULL;
+		}
+	}
+
+	return p + 1;
+}
+static const char *json_value(const char *p)
+{
+	p += strspn(p, " \t\r\n");
+	if (*p == '{' || *p == '[')
+	{
+		char close = *p == '{' ? '}' : ']';
+		p++;
+		p += strspn(p, " \t\r\n");
+		if (*p == close)
+			return p + 1;
+		for (;;)
+		{
+			if (close == '}')
+			{
+				if (!(p = json_string(p + strspn(p, " \t\r\n"))))
+					return NULL;
+				p += strspn(p, " \t\r\n");
+				if (*p++ != ':')
+					return NULL;
+			}
+			if (!(p = json_value(p)))
+				return NULL;
+			p += strspn(p, " \t\r\n");
+			if (*p == close)
+				return p + 1;
+			if (*p++ != ',')
+				return NULL;
+		}
+	}
+	if (*p == '"')
+		return json_string(p);
+	if (strncmp(p, "true", 4) == 0 || strncmp(p, "null", 4) == 0)
+		return p + 4;
+	if (strncmp(p, "false", 5) == 0)
+		return p + 5;
+
+	char *end;
+	strtod(p, &end);
+	return end == p ? NULL : end;
+}
+// a whole document: one value and nothing after it
+static int json_document(const char *text)
+{
+	const char *end = json_value(text);
+	return end && end[strspn(end, " \t\r\n")] == '\0';
+}
+static int count_of(const char *text, const char *needle)
+{
+	int count = 0;
+	for (const char *at = text; (at = strstr(at, needle)); at++)
+		count++;
+
+	return count;
+}
+//	a minimal XML reader: elements must nest, attribute values must be quoted, hold no raw `<`
+//	and start every `&` with an entity; returns the number of root elements, or -1 when malformed
+static int xml_roots(const char *p)
+{
+	char stack[16][32];
+	int depth = 0, roots = 0;
+	while ((p = strchr(p, '<')))
+	{
+		if (p[1] == '?')
+		{
+			if (!(p = strstr(p, "?>")))
+				return -1;
+			p += 2;
+			continue;
+		}
+		int closing = p[1] == '/';
+		p += 1 + closing;
+		size_t n = strspn(p, "abcdefghijklmnopqrstuvwxyz_");
+		if (!n || n >= sizeof(stack[0]))
+			return -1;
+		char name[32];
+		memcpy(name, p, n);
+		name[n] = '\0';
+		p += n;
+		if (closing)
+		{
+			if (!depth || strcmp(stack[--depth], name) != 0 || *p++ != '>')
+				return -1;
+			continue;
+		}
+
+		for (;;)
+		{
+			p += strspn(p, " ");
+			if (*p == '>' || (p[0] == '/' && p[1] == '>'))
+				break;
+			size_t len = strspn(p, "abcdefghijklmnopqrstuvwxyz_");
+			if (!len || p[len] != '=' || p[len + 1] != '"')
+				return -1;
+			for (p += len + 2; *p != '"'; p++)
+			{
+				if (!*p || *p == '<')
+					return -1;
+				if (*p == '&' && strncmp(p, "&quot;", 6) != 0 && strncmp(p, "&amp;", 5) != 0 &&
+					 strncmp(p, "&lt;", 4) != 0 && strncmp(p, "&gt;", 4) != 0 && p[1] != '#')
+					return -1;
+			}
+			p++;
+		}
+		if (!depth)
+			roots++;
+		if (*p == '/')
+		{
+			p += 2;
+			continue;
+		}
+		if (depth == 16)
+			return -1;
+		strcpy(stack[depth++], name);
+		p++;
+	}
+
+	return depth ? -1 : roots;
+}
+
+void binary_test_true(void)
+{
+	Assert.isTrue(1 == 1, "1 should equal 1");
+}
+void binary_test_fail(void)
+{
+	Assert.isTrue(1 == 0, "1 should not equal 0");
+}
+void binary_test_skip(void)
+{
+	Assert.skip("This test is skipped");
+}
+void binary_test_throws(void)
+{
+	Assert.throw("This test is \"explicitly\" thrown");
+}
+void binary_test_markup(void)
+{
+	Assert.skip("<b>skipped</b> & \"quoted\" \\ in C:\\tmp");
+}
+
+void binary_convert_json(void)
+{
+	char *one = convert("json", BINARY_LOG);
+	char *more = convert("json", BINARY_MORE_LOG);
+	int parsed = one && more && json_document(one) && json_document(more);
+	int objects = parsed && one[0] == '{' && more[0] == '{';
+	free(one);
+	free(more);
+	Assert.isTrue(parsed, "each set's stream should convert to a JSON document");
+	Assert.isTrue(objects, "a stream with one set should convert to the json_hooks object");
+
+	char *all = convert("json", BINARY_ALL_LOG);
+	parsed = all && json_document(all);
+	int sets = all && all[0] == '[' ? count_of(all, "\"test_set\":") : 0;
+	free(all);
+	Assert.isTrue(parsed, "a stream with two sets should convert to one JSON document");
+	Assert.isTrue(sets == 2, "both sets should be in one array, got %d", sets);
+}
+void binary_convert_junit(void)
+{
+	char *one = convert("junit", BINARY_LOG);
+	char *more = convert("junit", BINARY_MORE_LOG);
+	int roots = one && more && xml_roots(one) == 1 && xml_roots(more) == 1;
+	int escaped = more && strstr(more, "message=\"&lt;b&gt;skipped&lt;/b&gt; &amp; &quot;quoted&quot;");
+	free(one);
+	free(more);
+	Assert.isTrue(roots, "each set's stream should convert to one JUnit document");
+	Assert.isTrue(escaped, "attribute values should be escaped with entities");
+
+	char *all = convert("junit", BINARY_ALL_LOG);
+	int root = all ? xml_roots(all) : -1;
+	int suites = root == 1 ? count_of(all, "<testsuite ") : 0;
+	free(all);
+	Assert.isTrue(root == 1, "a stream with two sets should convert to one <testsuites>, got %d roots", root);
+	Assert.isTrue(suites == 2, "both sets should be in the one <testsuites>, got %d", suites);
+}
+
+// join the two sets' streams into one, header and all, as a shared stream would carry them
+static void join_streams(void)
+{
+	long first_size = 0, second_size = 0;
+	char *first = read_file(BINARY_LOG, &first_size);
+	char *second = read_file(BINARY_MORE_LOG, &second_size);
+	FILE *out = fopen(BINARY_ALL_LOG, "wb");
+	if (out)
+	{
+		if (first)
+			fwrite(first, 1, first_size, out);
+		if (second)
+			fwrite(second, 1, second_size, out);
+		fclose(out);
+	}
+	free(first);
+	free(second);
+}
+
+// Register test cases
+__attribute__((constructor)) void init_binary_tests(void)
+{
+	static struct BinaryHookContext ctx = {
+		 .stream = NULL,
+		 .set = NULL,
+		 .header_stream = NULL,
+		 .sequence = 0,
+		 .used = 0,
+	};
+	binary_hooks.context = &ctx;
+
+	// Register the check set first so it runs after the streams are written
+	testset("binary_check_set", check_config, NULL);
+	register_hooks((SigtestHooks)&binary_hooks);
+	setup_testcase(join_streams);
+	testcase("binary_convert_json", binary_convert_json);
+	testcase("binary_convert_junit", binary_convert_junit);
+
+	testset("binary_more_set", more_config, NULL);
+	register_hooks((SigtestHooks)&binary_hooks);
+	testcase("binary_test_markup", binary_test_markup);
+
+	// Register the test set
+	testset("binary_set", set_config, NULL);
+
+	// Register the test hooks
+	register_hooks((SigtestHooks)&binary_hooks);
+
+	// Register the test cases
+	testcase("binary_test_true", binary_test_true);
+	fail_testcase("binary_test_fail", binary_test_fail);
+	testcase("binary_test_skip", binary_test_skip);
+	testcase_throws("binary_test_throws", binary_test_throws);
+}
@@ -0,0 +1,70 @@
+// test_crash.c
+#include "sigtest.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Test cases for in-process crash containment, run with quarantine: each crashing case
+ * reports CRASH (so this executable exits with failures), the rest of its set is skipped,
+ * and the following sets still run.
+ */
+static int *volatile nowhere = NULL;
+static volatile int zero = 0;
+static volatile int ten = 10;
+
+static void crash_segv_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_crash_segv.log", "w");
+}
+static void crash_abort_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_crash_abort.log", "w");
+}
+static void crash_fpe_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_crash_fpe.log", "w");
+}
+
+void crash_null_deref(void)
+{
+	*nowhere = 42;
+}
+void crash_quarantined(void)
+{
+	Assert.fail("a quarantined case should never run");
+}
+void crash_abort(void)
+{
+	abort();
+}
+void crash_divide_by_zero(void)
+{
+	// integer division traps on x86; raise it where it does not
+	int result = ten / zero;
+	(void)result;
+	raise(SIGFPE);
+}
+void crash_runner_recovered(void)
+{
+	Assert.isTrue(1 == 1, "the runner should keep going after a crash");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_crash_tests(void)
+{
+	// opt in before the runner starts; the environment still wins
+	setenv("SIGTEST_CRASH_GUARD", "quarantine", 0);
+
+	// Register the test sets
+	testset("crash_segv_set", crash_segv_config, NULL);
+	testcase("crash_null_deref", crash_null_deref);
+	testcase("crash_quarantined", crash_quarantined);
+
+	testset("crash_abort_set", crash_abort_config, NULL);
+	testcase("crash_runner_recovered", crash_runner_recovered);
+	testcase("crash_abort", crash_abort);
+
+	testset("crash_fpe_set", crash_fpe_config, NULL);
+	testcase("crash_divide_by_zero", crash_divide_by_zero);
+}
@@ -0,0 +1,76 @@
+// test_fanout.c
+#include "sigtest.h"
+
+/*
+ * Test case for fan-out hooks: the default console hooks and a counting
+ * member receive every event of a single run with independent contexts.
+ */
+struct CountingContext
+{
+	int before_set;
+	int before_test;
+	int after_test;
+	int results;
+};
+
+static struct CountingContext counts = {0, 0, 0, 0};
+
+static void set_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_fanout.log", "w");
+}
+//	counting member hooks
+static void count_before_set(const TestSet set, object context)
+{
+	((struct CountingContext *)context)->before_set++;
+}
+static void count_before_test(object context)
+{
+	((struct CountingContext *)context)->before_test++;
+}
+static void count_after_test(object context)
+{
+	((struct CountingContext *)context)->after_test++;
+}
+static void count_on_test_result(const TestSet set, const TestCase tc, object context)
+{
+	((struct CountingContext *)context)->results++;
+}
+static struct sigtest_hooks_s counting_hooks = {
+	 .name = "counting_hooks",
+	 .before_set = count_before_set,
+	 .before_test = count_before_test,
+	 .after_test = count_after_test,
+	 .on_test_result = count_on_test_result,
+	 .context = &counts,
+};
+
+//	test cases
+static void test_member_before_set(void)
+{
+	Assert.isTrue(counts.before_set == 1, "Member before_set should be called once, got %d", counts.before_set);
+}
+static void test_member_before_test(void)
+{
+	Assert.isTrue(counts.before_test == 2, "Member before_test should be called twice, got %d", counts.before_test);
+}
+static void test_member_results(void)
+{
+	Assert.isTrue(counts.after_test == 2, "Member after_test should be called twice, got %d", counts.after_test);
+	Assert.isTrue(counts.results == 2, "Member results should be delivered twice, got %d", counts.results);
+}
+
+// Register test cases
+__attribute__((constructor)) void init_fanout_tests(void)
+{
+	testset("fanout_set", set_config, NULL);
+
+	SigtestHooks fanout = init_fanout_hooks("fanout");
+	fanout_add_hooks(fanout, init_hooks("default"), NULL);
+	fanout_add_hooks(fanout, &counting_hooks, NULL);
+	register_hooks(fanout);
+
+	testcase("member_before_set", test_member_before_set);
+	testcase("member_before_test", test_member_before_test);
+	testcase("member_results", test_member_results);
+}
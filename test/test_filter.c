@@ -0,0 +1,81 @@
+// test_filter.c
+#include "sigtest_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for name filters: a whole set selected by name, a case excluded by a glob,
+ * cases picked out of a set by a regex holding an escaped comma, and a set nothing selects. Only the selected cases
+ * run and are reported, and the set nothing selects is never configured.
+ */
+#define FILTER_SPEC "filter_run_set,re:^filter_regex_set/keep_[0-9]{1\\,2}$,filter_check_set/*,-*_excluded"
+
+static int ran = 0;
+static int unselected_configs = 0;
+
+static void filter_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_filter_check.log", "w");
+}
+static void filter_regex_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_filter_regex.log", "w");
+}
+static void filter_run_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_filter_run.log", "w");
+}
+
+static void unselected_config(FILE **log_stream)
+{
+	unselected_configs++;
+	*log_stream = fopen("logs/test_filter_unselected.log", "w");
+}
+
+void filter_included(void)
+{
+	ran++;
+	Assert.isTrue(1 == 1, "a case in a selected set should run");
+}
+void filter_excluded(void)
+{
+	Assert.fail("an excluded case should not run");
+}
+void filter_kept(void)
+{
+	ran++;
+	Assert.isTrue(1 == 1, "a case the regex matches should run");
+}
+void filter_dropped(void)
+{
+	Assert.fail("a case the regex does not match should not run");
+}
+void filter_ran(void)
+{
+	Assert.isTrue(ran == 3, "only the selected cases should run, but %d did", ran);
+	Assert.isTrue(unselected_configs == 0, "a set with no selected case should not be configured");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_filter_tests(void)
+{
+	setenv("SIGTEST_FILTER", FILTER_SPEC, 0);
+
+	// Register the test sets
+	testset("filter_check_set", filter_check_config, NULL);
+	testcase("filter_ran", filter_ran);
+
+	testset("filter_unselected_set", unselected_config, NULL);
+	testcase("filter_included", filter_dropped);
+
+	testset("filter_regex_set", filter_regex_config, NULL);
+	testcase("keep_1", filter_kept);
+	testcase("keep_x", filter_dropped);
+	testcase("keep_22", filter_kept);
+	testcase("drop_1", filter_dropped);
+
+	testset("filter_run_set", filter_run_config, NULL);
+	testcase("filter_included", filter_included);
+	testcase("filter_excluded", filter_excluded);
+}
@@ -0,0 +1,127 @@
+// test_fork.c
+#include "sigtest.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for forked isolation: every case sees the fixture exactly as the set config
+ * left it, no matter what earlier cases did to it. The crashing and hanging cases fail by
+ * design (this executable exits with failures); the cases after them still run, including
+ * those already queued to a worker that crashes, which the runner must survive writing to.
+ */
+#define FIXTURE_SIZE 4096
+
+static char *fixture = NULL;
+static int *volatile nowhere = NULL;
+static int batched = 0;
+
+//	every set starts from the same fixture
+static void make_fixture(void)
+{
+	if (!fixture)
+	{
+		fixture = malloc(FIXTURE_SIZE);
+		memset(fixture, 'a', FIXTURE_SIZE);
+	}
+}
+static void fork_case_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_fork_case.log", "w");
+	make_fixture();
+}
+static void fork_crash_run_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_fork_crash_run.log", "w");
+	make_fixture();
+}
+static void fork_batch_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_fork_batch.log", "w");
+	make_fixture();
+}
+static void set_cleanup(void)
+{
+	free(fixture);
+	fixture = NULL;
+}
+
+void fork_scribble_fixture(void)
+{
+	Assert.isTrue(fixture[0] == 'a', "the fixture should be pristine");
+	memset(fixture, 'z', FIXTURE_SIZE);
+}
+void fork_fixture_pristine(void)
+{
+	Assert.isTrue(fixture[0] == 'a' && fixture[FIXTURE_SIZE - 1] == 'a', "the previous case's writes should not be visible");
+	fixture[0] = 'z';
+}
+void fork_crash(void)
+{
+	*nowhere = 42;
+}
+void fork_after_crash(void)
+{
+	Assert.isTrue(fixture[0] == 'a', "the runner should keep going after a worker crash");
+}
+void fork_hang(void)
+{
+	for (;;)
+		;
+}
+void fork_after_hang(void)
+{
+	Assert.isTrue(fixture[0] == 'a', "the runner should keep going after a worker is killed");
+}
+void fork_between_crashes(void)
+{
+	struct sigaction action;
+	sigaction(SIGPIPE, NULL, &action);
+	Assert.isTrue(fixture[0] == 'a', "queued cases should survive a worker dying under them");
+	Assert.isTrue(action.sa_handler == SIG_DFL, "the runner ignores SIGPIPE for itself, not for the cases");
+}
+void fork_batch_first(void)
+{
+	batched++;
+}
+void fork_batch_second(void)
+{
+	int expected = 1;
+	Assert.areEqual(&expected, &batched, INT, "cases sharing a worker should share its state");
+}
+void fork_batch_recycled(void)
+{
+	int expected = 0;
+	Assert.areEqual(&expected, &batched, INT, "a recycled worker should start from the configured set");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_fork_tests(void)
+{
+	// Register the test sets
+	testset("fork_case_set", fork_case_config, set_cleanup);
+	isolate_testset(1);
+	testcase("fork_scribble_fixture", fork_scribble_fixture);
+	testcase("fork_fixture_pristine", fork_fixture_pristine);
+	testcase("fork_crash", fork_crash);
+	testcase("fork_after_crash", fork_after_crash);
+	testcase("fork_hang", fork_hang);
+	timeout_testcase(100);
+	testcase("fork_after_hang", fork_after_hang);
+
+	testset("fork_crash_run_set", fork_crash_run_config, set_cleanup);
+	isolate_testset(8);
+	testcase("fork_crash_first", fork_crash);
+	testcase("fork_after_first_crash", fork_between_crashes);
+	testcase("fork_crash_second", fork_crash);
+	testcase("fork_after_second_crash", fork_between_crashes);
+	testcase("fork_crash_third", fork_crash);
+	testcase("fork_after_third_crash", fork_between_crashes);
+
+	testset("fork_batch_set", fork_batch_config, NULL);
+	isolate_testset(2);
+	testcase("fork_batch_first", fork_batch_first);
+	testcase("fork_batch_second", fork_batch_second);
+	testcase("fork_batch_recycled", fork_batch_recycled);
+}
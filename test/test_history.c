@@ -0,0 +1,104 @@
+// test_history.c
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for failed-first ordering from a result store left by an "earlier run": the
+ * case that failed runs first, then the case the store has never seen, then the rest, and
+ * the set holding the failure runs ahead of the set registered to run before it. A store line
+ * longer than any fixed buffer loads whole.
+ */
+#define HISTORY_PATH "logs/test_history.history"
+#define HISTORY_LONG_PATH "logs/test_history_long.history"
+#define HISTORY_LONG_NAME 1500
+
+static char ran[128] = "";
+
+static void history_order_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_history_order.log", "w");
+}
+static void history_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_history_check.log", "w");
+}
+
+void history_stable(void)
+{
+	strcat(ran, "stable,");
+	Assert.isTrue(1 == 1, "a case that passed last time should run last");
+}
+void history_new(void)
+{
+	strcat(ran, "new,");
+	Assert.isTrue(1 == 1, "a case missing from the history should run second");
+}
+void history_failed(void)
+{
+	strcat(ran, "failed,");
+	Assert.isTrue(1 == 1, "a case that failed last time should run first");
+}
+void history_ordered(void)
+{
+	string expected = "failed,new,stable,";
+	Assert.stringEqual(expected, ran, 1, "the likely failures should run first, but ran %s", ran);
+}
+void history_long_line(void)
+{
+	static char name[HISTORY_LONG_NAME + 1];
+	memset(name, 'n', HISTORY_LONG_NAME);
+	FILE *out = fopen(HISTORY_LONG_PATH, "w");
+	fprintf(out, "# sigtest history v3\n");
+	fprintf(out, "history_long_set\t%s\tFAIL\t0\t5000\tF\t-\n", name);
+	fprintf(out, "history_long_set\tshort\tPASS\t0\t7000\tP\t7000\n");
+	fclose(out);
+
+	struct sigtest_set_s set = {.name = "history_long_set"};
+	struct sigtest_case_s long_case = {.name = name, .id_hash = test_id_hash(set.name, name)};
+	struct sigtest_case_s short_case = {.name = "short", .id_hash = test_id_hash(set.name, "short")};
+	History *history = history_open(HISTORY_LONG_PATH);
+	double long_ns = history_duration(history, &set, &long_case);
+	double short_ns = history_duration(history, &set, &short_case);
+	history_close(history);
+	Assert.isTrue(long_ns == 5000.0, "a %d character name should load, got %.0f", HISTORY_LONG_NAME, long_ns);
+	Assert.isTrue(short_ns == 7000.0, "the line after it should load, got %.0f", short_ns);
+}
+
+//	the fingerprint the store keeps for an unchanged body
+static unsigned long body_size(void (*func)(void))
+{
+	Dl_info info;
+	const ElfW(Sym) *symbol = NULL;
+	if (!dladdr1((void *)func, &info, (void **)&symbol, RTLD_DL_SYMENT) || !symbol)
+		return 0;
+
+	return (unsigned long)symbol->st_size;
+}
+
+// Register test cases
+__attribute__((constructor)) void init_history_tests(void)
+{
+	// the earlier run: one case passed, one failed, and history_new did not exist yet
+	FILE *history = fopen(HISTORY_PATH, "w");
+	fprintf(history, "# sigtest history v1\n");
+	fprintf(history, "history_order_set\thistory_stable\tPASS\t%lu\t1000\n", body_size(history_stable));
+	fprintf(history, "history_order_set\thistory_failed\tFAIL\t%lu\t1000\n", body_size(history_failed));
+	fclose(history);
+	setenv("SIGTEST_HISTORY", HISTORY_PATH, 0);
+	setenv("SIGTEST_ORDER", "failed-first", 0);
+
+	// Register the test sets; declared order would run the check set first
+	testset("history_order_set", history_order_config, NULL);
+	testcase("history_stable", history_stable);
+	testcase("history_new", history_new);
+	testcase("history_failed", history_failed);
+
+	testset("history_check_set", history_check_config, NULL);
+	testcase("history_ordered", history_ordered);
+	testcase("history_long_line", history_long_line);
+}
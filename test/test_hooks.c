@@ -35,8 +35,6 @@ __attribute__((constructor)) void init_sigtest_tests(void)
 	static struct JsonHookContext ctx = {
 		 .count = 0,
 		 .verbose = 0,
-		 .start = {0, 0},
-		 .end = {0, 0},
 		 .set = NULL,
 	};
 	// Register the test set
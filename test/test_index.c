@@ -0,0 +1,66 @@
+// test_index.c
+#include "sigtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for the registry index: cases are found by set and case name across enough
+ * registrations to grow the index, and a duplicate id keeps its first registration.
+ */
+#define INDEX_BULK_CASES 600
+
+static void index_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_index_check.log", "w");
+}
+static void index_bulk_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_index_bulk.log", "w");
+}
+
+void index_bulk(void)
+{
+	Assert.isTrue(1 == 1, "a bulk case should run");
+}
+void index_first(void)
+{
+	Assert.isTrue(1 == 1, "the first registration should run");
+}
+void index_second(void)
+{
+	Assert.isTrue(1 == 1, "the duplicate registration still runs");
+}
+void index_lookup(void)
+{
+	TestSet owner = NULL;
+	TestCase tc = find_testcase("index_bulk_set", "bulk_599", &owner);
+	Assert.isNotNull(tc, "a registered case should be found");
+	Assert.isTrue(owner && strcmp(owner->name, "index_bulk_set") == 0, "the case's set should be returned");
+	Assert.isTrue(strcmp(tc->name, "bulk_599") == 0, "the case found should be the one asked for");
+	Assert.isNull(find_testcase("index_bulk_set", "bulk_600", NULL), "an unknown id should not be found");
+	Assert.isNull(find_testcase("index_bulk", "set/bulk_1", NULL), "set and case names should not run together");
+}
+void index_duplicate(void)
+{
+	TestCase tc = find_testcase("index_check_set", "index_twice", NULL);
+	Assert.isTrue(tc && tc->test_func == index_first, "a duplicate id should keep its first registration");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_index_tests(void)
+{
+	testset("index_check_set", index_check_config, NULL);
+	testcase("index_lookup", index_lookup);
+	testcase("index_duplicate", index_duplicate);
+	testcase("index_twice", index_first);
+	testcase("index_twice", index_second);
+
+	testset("index_bulk_set", index_bulk_config, NULL);
+	for (int i = 0; i < INDEX_BULK_CASES; i++)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "bulk_%d", i);
+		testcase(name, index_bulk);
+	}
+}
@@ -0,0 +1,92 @@
+// test_journal.c
+#include "sigtest_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for the completion journal, resuming from a journal left by an "earlier run":
+ * journaled cases are replayed instead of run, the torn last line is ignored, and cases
+ * run now are appended for the next resume. The runner flags that turn it on reject bad values.
+ */
+#define JOURNAL_PATH "logs/test_journal.journal"
+
+static void journal_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_journal_check.log", "w");
+}
+static void journal_resume_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_journal_resume.log", "w");
+}
+
+void journal_completed(void)
+{
+	Assert.fail("a journaled case should not run again");
+}
+void journal_expected_failure(void)
+{
+	Assert.fail("a journaled case should not run again");
+}
+void journal_torn(void)
+{
+	Assert.isTrue(1 == 1, "a torn journal line should not count as completed");
+}
+void journal_not_started(void)
+{
+	Assert.isTrue(1 == 1, "a case missing from the journal should run");
+}
+void journal_appended(void)
+{
+	// the sets above have run; their new cases are in the journal now
+	FILE *journal = fopen(JOURNAL_PATH, "r");
+	Assert.isNotNull(journal, "the journal should exist");
+	char line[256];
+	int torn = 0, not_started = 0;
+	while (journal && fgets(line, sizeof(line), journal))
+	{
+		torn += strncmp(line, "journal_resume_set\tjournal_torn\tPASS\t", 37) == 0;
+		not_started += strncmp(line, "journal_resume_set\tjournal_not_started\tPASS\t", 44) == 0;
+	}
+	if (journal)
+		fclose(journal);
+	Assert.isTrue(torn == 1 && not_started == 1, "the cases run now should be journaled once");
+}
+void journal_options(void)
+{
+	// the flags are applied after this run read its environment; only rejections are checked
+	Assert.isTrue(sigtest_option("--workers=abc") < 0, "a worker count should be a number");
+	Assert.isTrue(sigtest_option("--fork=4097") < 0, "a worker count should be at most 4096");
+	Assert.isTrue(sigtest_option("--timeout=-5") < 0, "a timeout should not be negative");
+	Assert.isTrue(sigtest_option("--repeat-for=soon") < 0, "a duration should parse");
+	Assert.isTrue(sigtest_option("--resume=0") < 0, "a switch should take no value");
+	Assert.isTrue(sigtest_option("--resumed") == 0, "an unknown flag should not be applied");
+	Assert.isTrue(sigtest_option("--trend-top=3") == 1 && strcmp(getenv("SIGTEST_TREND_TOP"), "3") == 0,
+					  "a valid value should be set");
+	unsetenv("SIGTEST_TREND_TOP");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_journal_tests(void)
+{
+	// the earlier run: two cases finished, the third was being written when it died
+	FILE *journal = fopen(JOURNAL_PATH, "w");
+	fprintf(journal, "# sigtest journal v1\n");
+	fprintf(journal, "journal_resume_set\tjournal_completed\tPASS\t1200\t\n");
+	fprintf(journal, "journal_resume_set\tjournal_expected_failure\tFAIL\t800\tfailed\\tas planned\n");
+	fprintf(journal, "journal_resume_set\tjournal_torn\tPA");
+	fclose(journal);
+	setenv("SIGTEST_JOURNAL", JOURNAL_PATH, 0);
+	setenv("SIGTEST_RESUME", "1", 0);
+
+	// Register the test sets
+	testset("journal_check_set", journal_check_config, NULL);
+	testcase("journal_appended", journal_appended);
+	testcase("journal_options", journal_options);
+
+	testset("journal_resume_set", journal_resume_config, NULL);
+	testcase("journal_completed", journal_completed);
+	fail_testcase("journal_expected_failure", journal_expected_failure);
+	testcase("journal_torn", journal_torn);
+	testcase("journal_not_started", journal_not_started);
+}
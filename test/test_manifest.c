@@ -0,0 +1,84 @@
+// test_manifest.c
+#include "sigtest_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for the test manifest: every registered case is listed with its id, tags and
+ * expectation, in JSON and in the binary stream framing. `--list` writes the same
+ * manifest from the command line without running anything.
+ */
+#define MANIFEST_JSON "logs/test_manifest.json"
+#define MANIFEST_BIN "logs/test_manifest.bin"
+
+static void set_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_manifest.log", "w");
+}
+
+static char *read_file(const char *path, long *size)
+{
+	FILE *in = fopen(path, "rb");
+	if (!in)
+		return NULL;
+	fseek(in, 0, SEEK_END);
+	*size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+	char *data = calloc(1, *size + 1);
+	if (data && fread(data, 1, *size, in) != (size_t)*size)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(in);
+
+	return data;
+}
+
+void manifest_json(void)
+{
+	Assert.isTrue(sigtest_list(test_sets, NULL, NULL, "json", MANIFEST_JSON) == EXIT_SUCCESS, "the manifest should be written");
+	long size = 0;
+	char *json = read_file(MANIFEST_JSON, &size);
+	Assert.isNotNull(json, "the manifest should exist");
+	int listed = strstr(json, "\"id\": \"manifest_set/manifest_json\"") && strstr(json, "\"id\": \"manifest_set/manifest_binary\"");
+	int tagged = strstr(json, "\"tags\": [\"fast\", \"io\"], \"expect\": \"fail\"") != NULL;
+	free(json);
+	Assert.isTrue(listed, "every case should be listed by id");
+	Assert.isTrue(tagged, "cases should be listed with their tags and expectation");
+}
+void manifest_binary(void)
+{
+	Assert.isTrue(sigtest_list(test_sets, NULL, NULL, "binary", MANIFEST_BIN) == EXIT_SUCCESS, "the manifest should be written");
+	long size = 0;
+	char *data = read_file(MANIFEST_BIN, &size);
+	Assert.isNotNull(data, "the manifest should exist");
+
+	// walk the records: u8 type | u32 length | payload
+	int records = 0;
+	long pos = 8;
+	while (pos + 5 <= size && data[pos] == 4)
+	{
+		unsigned char *length = (unsigned char *)data + pos + 1;
+		pos += 5 + (length[0] | length[1] << 8 | length[2] << 16 | (long)length[3] << 24);
+		records++;
+	}
+	int magic = size >= 8 && memcmp(data, "SGTB", 4) == 0;
+	free(data);
+	Assert.isTrue(magic && records == 3 && pos == size, "three manifest records should fill the stream, got %d", records);
+}
+void manifest_tagged(void)
+{
+	Assert.fail("an expected failure");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_manifest_tests(void)
+{
+	testset("manifest_set", set_config, NULL);
+	testcase("manifest_json", manifest_json);
+	testcase("manifest_binary", manifest_binary);
+	fail_testcase("manifest_tagged", manifest_tagged);
+	tag_testcase("fast,io");
+}
@@ -0,0 +1,69 @@
+// test_max_failures.c
+#include "sigtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Test cases for fail-fast: the run stops after its second failure (so this executable
+ * exits with failures). The remaining cases are reported as NOT_RUN and the set's cleanup
+ * still runs. The later set is only counted: its config, cleanup and hooks never run, so it
+ * writes no log (and the executable exits with 2 if it is configured).
+ */
+static FILE *log = NULL;
+
+static void max_failures_later_config(FILE **log_stream)
+{
+	(void)log_stream;
+	fwritelnf(stderr, "Error: max_failures_later_set was configured after the run stopped");
+	exit(2);
+}
+static void max_failures_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_max_failures.log", "w");
+	log = *log_stream;
+}
+static void set_cleanup(void)
+{
+	fwritelnf(log, "cleanup ran");
+}
+
+void max_failures_pass(void)
+{
+	Assert.isTrue(1 == 1, "1 should equal 1");
+}
+void max_failures_first(void)
+{
+	Assert.fail("the first failure");
+}
+void max_failures_expected(void)
+{
+	// an expected failure is a pass and does not count toward the limit
+	Assert.fail("an expected failure");
+}
+void max_failures_second(void)
+{
+	Assert.fail("the second failure reaches the limit");
+}
+void max_failures_never(void)
+{
+	Assert.fail("a case past the failure limit should never run");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_max_failures_tests(void)
+{
+	// opt in before the runner starts; the environment still wins
+	setenv("SIGTEST_MAX_FAILURES", "2", 0);
+
+	// Register the test sets
+	testset("max_failures_later_set", max_failures_later_config, set_cleanup);
+	testcase("max_failures_never", max_failures_never);
+	testcase("max_failures_pass", max_failures_pass);
+
+	testset("max_failures_set", max_failures_config, set_cleanup);
+	testcase("max_failures_pass", max_failures_pass);
+	testcase("max_failures_first", max_failures_first);
+	fail_testcase("max_failures_expected", max_failures_expected);
+	testcase("max_failures_second", max_failures_second);
+	testcase("max_failures_never", max_failures_never);
+}
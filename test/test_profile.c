@@ -0,0 +1,55 @@
+// test_profile.c
+#include "sigtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Test case for the sampling profiler; folded stacks are written to
+ * `logs/test_profile.folded` (feed them to flamegraph.pl or speedscope).
+ * Only cases running at least 1 ms are kept, so `profile_short` should not appear.
+ */
+static volatile unsigned long sink = 0;
+
+static void set_config(FILE **log_stream)
+{
+	// initialize the log stream
+	*log_stream = fopen("logs/test_profile.log", "w");
+}
+
+void spin(long iterations)
+{
+	for (long i = 0; i < iterations; i++)
+	{
+		sink += i ^ (sink >> 3);
+	}
+}
+void spin_outer(long iterations)
+{
+	spin(iterations);
+}
+
+void profile_busy(void)
+{
+	spin_outer(20000000L);
+	Assert.isTrue(sink != 0, "busy loop should have run");
+}
+void profile_short(void)
+{
+	spin(100);
+	Assert.isTrue(1 == 1, "1 should equal 1");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_profile_tests(void)
+{
+	// opt in before the runner starts; the environment still wins
+	setenv("SIGTEST_PROFILE", "logs/test_profile.folded", 0);
+	setenv("SIGTEST_PROFILE_MIN_US", "1000", 0);
+
+	// Register the test set
+	testset("profile_set", set_config, NULL);
+
+	// Register the test cases
+	testcase("profile_busy", profile_busy);
+	testcase("profile_short", profile_short);
+}
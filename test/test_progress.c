@@ -0,0 +1,163 @@
+// test_progress.c
+#include "sigtest_internal.h"
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Test cases for the live status line, drawn into a pipe: it counts the cases done and failed,
+ * names the running set, estimates the time left from the result store and is erased when
+ * stopped. The runner draws it only on a terminal, so running these under `--progress` with
+ * stderr redirected draws nothing. One case reruns this executable on a pseudo terminal, where
+ * a set logging to the console must not have its per-case lines written over the status line.
+ */
+#define PROGRESS_PATH "logs/test_progress.history"
+#define PROGRESS_TTY "SIGTEST_PROGRESS_TTY"
+
+static void progress_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_progress_check.log", "w");
+}
+static void progress_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_progress.log", "w");
+}
+
+void progress_first(void)
+{
+	Assert.isTrue(1 == 1, "the first case passes");
+}
+void progress_second(void)
+{
+	Assert.isTrue(1 == 1, "the second case passes");
+}
+void progress_new(void)
+{
+	Assert.isTrue(1 == 1, "the store has not seen this case");
+}
+
+void progress_check_line(void)
+{
+	int pipefd[2];
+	Assert.isTrue(pipe(pipefd) == 0, "the pipe should open");
+	History *history = history_open(PROGRESS_PATH);
+	TestSet set = NULL;
+	TestCase first = find_testcase("progress_set", "progress_first", &set);
+	TestCase second = find_testcase("progress_set", "progress_second", NULL);
+	TestCase added = find_testcase("progress_set", "progress_new", NULL);
+
+	Progress *progress = progress_start(&set, 1, history, pipefd[1]);
+	Assert.isNotNull(progress, "the status line thread should start");
+	progress_set(progress, set);
+	progress_done(progress, set, first);
+	progress_done(progress, set, second);
+	// counted as a failure; its run has already been reported as the pass it was
+	added->test_result.state = FAIL;
+	progress_done(progress, set, added);
+	added->test_result.state = PASS;
+	progress_workers(progress, 2);
+	usleep(2 * 1000000 / PROGRESS_HZ);
+	progress_stop(progress);
+	history_close(history);
+	close(pipefd[1]);
+
+	char line[4096] = {0};
+	ssize_t length = 0, n = 0;
+	while ((n = read(pipefd[0], line + length, sizeof(line) - 1 - length)) > 0)
+		length += n;
+	close(pipefd[0]);
+	Assert.isTrue(strstr(line, "[3/3] 1 failed, 2 workers  set 1/1 progress_set  ETA ") != NULL,
+					  "a frame should show the counts, workers and set");
+	Assert.isTrue(length >= 4 && strcmp(line + length - 4, "\r\033[K") == 0, "stopping should erase the line");
+}
+
+//	the sets run on the pseudo terminal: one logs to a file while the line is drawn, one to the console
+static void tty_file_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_progress_tty.log", "w");
+}
+void progress_tty_quiet(void)
+{
+	usleep(3 * 1000000 / PROGRESS_HZ);
+	Assert.isTrue(1 == 1, "the line is drawn while this set logs to a file");
+}
+void progress_tty_console(void)
+{
+	usleep(2 * 1000000 / PROGRESS_HZ);
+	Assert.isTrue(1 == 1, "this set logs each case to the console");
+}
+
+void progress_check_terminal(void)
+{
+	int terminal = -1;
+	pid_t pid = forkpty(&terminal, NULL, NULL, NULL);
+	Assert.isTrue(pid >= 0, "the pseudo terminal should open");
+	if (pid == 0)
+	{
+		setenv(PROGRESS_TTY, "1", 1);
+		execl("/proc/self/exe", "test_progress", (char *)NULL);
+		_exit(127);
+	}
+
+	static char output[65536];
+	ssize_t length = 0, n = 0;
+	// the read fails with EIO once the child has closed the terminal
+	while (length < (ssize_t)sizeof(output) - 1 && (n = read(terminal, output + length, sizeof(output) - 1 - length)) > 0)
+		length += n;
+	output[length] = '\0';
+	close(terminal);
+	int status = 0;
+	waitpid(pid, &status, 0);
+	Assert.isTrue(WIFEXITED(status) && WEXITSTATUS(status) == 0, "the run on the terminal should pass");
+
+	// what a line shows: the text after its last carriage return, the terminal's own \r\n aside
+	int frames = 0, overwritten = 0;
+	for (char *line = strtok(output, "\n"); line; line = strtok(NULL, "\n"))
+	{
+		size_t size = strlen(line);
+		if (size && line[size - 1] == '\r')
+			line[--size] = '\0';
+		frames += strstr(line, " ETA ") != NULL;
+		char *shown = strrchr(line, '\r');
+		shown = shown ? shown + 1 : line;
+		overwritten += strstr(shown, " ETA ") && strstr(shown, "Running:");
+	}
+	Assert.isTrue(frames > 0, "the line should be drawn while a set logs to a file");
+	Assert.isTrue(overwritten == 0, "%d case lines were written over the status line", overwritten);
+}
+
+// Register test cases
+__attribute__((constructor)) void init_progress_tests(void)
+{
+	// the earlier run: both cases took about a millisecond
+	FILE *history = fopen(PROGRESS_PATH, "w");
+	fprintf(history, "# sigtest history v3\n");
+	fprintf(history, "progress_set\tprogress_first\tPASS\t0\t1000000\tP\t1000000\n");
+	fprintf(history, "progress_set\tprogress_second\tPASS\t0\t1000000\tP\t1000000\n");
+	fclose(history);
+	setenv("SIGTEST_PROGRESS", "1", 0);
+	if (getenv(PROGRESS_TTY))
+	{
+		// the rerun on the pseudo terminal: the console set runs last, after frames were drawn
+		testset("progress_tty_console_set", NULL, NULL);
+		testcase("progress_tty_console_first", progress_tty_console);
+		testcase("progress_tty_console_second", progress_tty_console);
+
+		testset("progress_tty_file_set", tty_file_config, NULL);
+		testcase("progress_tty_quiet", progress_tty_quiet);
+		return;
+	}
+
+	// Register the test sets
+	testset("progress_check_set", progress_check_config, NULL);
+	testcase("progress_check_line", progress_check_line);
+	testcase("progress_check_terminal", progress_check_terminal);
+
+	testset("progress_set", progress_config, NULL);
+	testcase("progress_first", progress_first);
+	testcase("progress_second", progress_second);
+	testcase("progress_new", progress_new);
+}
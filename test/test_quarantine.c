@@ -0,0 +1,104 @@
+// test_quarantine.c
+#define _GNU_SOURCE
+#include "sigtest.h"
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for flaky quarantine from a result store left by "earlier runs": cases whose
+ * outcomes flipped often are quarantined, a quarantined failure is retried and, when it keeps
+ * failing, is reported without counting against the set; steady and edited cases are not.
+ */
+#define QUARANTINE_PATH "logs/test_quarantine.history"
+
+static void quarantine_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_quarantine_check.log", "w");
+}
+static void quarantine_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_quarantine.log", "w");
+}
+
+void quarantine_flaky(void)
+{
+	static int calls = 0;
+	Assert.isTrue(++calls > 1, "the flaky case fails its first attempt");
+}
+void quarantine_broken(void)
+{
+	Assert.fail("the quarantined case fails every attempt");
+}
+void quarantine_steady(void)
+{
+	Assert.isTrue(1 == 1, "a steady case should not be quarantined");
+}
+void quarantine_edited(void)
+{
+	Assert.isTrue(1 == 1, "flips of an earlier body should not count");
+}
+
+void quarantine_check_flaky(void)
+{
+	TestCase tc = find_testcase("quarantine_set", "quarantine_flaky", NULL);
+	Assert.isTrue(tc->quarantined && tc->flip_rate == 1.0, "alternating outcomes should quarantine the case");
+	Assert.isTrue(tc->attempts == 2 && tc->test_result.state == PASS, "a retry should pass, after %d attempts", tc->attempts);
+}
+void quarantine_check_broken(void)
+{
+	TestSet set = NULL;
+	TestCase tc = find_testcase("quarantine_set", "quarantine_broken", &set);
+	Assert.isTrue(tc->quarantined && tc->attempts == 3, "two retries should follow the failure, ran %d", tc->attempts);
+	Assert.isTrue(tc->test_result.state == FAIL, "the failure should still be reported");
+	Assert.isTrue(set->failed == 0 && set->quarantined == 1, "the failure should not count against the set");
+}
+void quarantine_check_unflagged(void)
+{
+	TestCase steady = find_testcase("quarantine_set", "quarantine_steady", NULL);
+	TestCase edited = find_testcase("quarantine_set", "quarantine_edited", NULL);
+	Assert.isTrue(!steady->quarantined && steady->flip_rate == 0.0, "steady outcomes should not quarantine");
+	Assert.isTrue(!edited->quarantined && edited->flip_rate < 0.0, "a changed body should start its outcomes over");
+	Assert.isTrue(steady->attempts == 1, "a case that passed should run once");
+}
+
+//	the fingerprint the store keeps for an unchanged body
+static unsigned long body_size(void (*func)(void))
+{
+	Dl_info info;
+	const ElfW(Sym) *symbol = NULL;
+	if (!dladdr1((void *)func, &info, (void **)&symbol, RTLD_DL_SYMENT) || !symbol)
+		return 0;
+
+	return (unsigned long)symbol->st_size;
+}
+
+// Register test cases
+__attribute__((constructor)) void init_quarantine_tests(void)
+{
+	// the earlier runs: two cases flipped on every run, one never did, one was edited since
+	FILE *history = fopen(QUARANTINE_PATH, "w");
+	fprintf(history, "# sigtest history v2\n");
+	fprintf(history, "quarantine_set\tquarantine_flaky\tPASS\t%lu\t1000\tPFPFPFPF\n", body_size(quarantine_flaky));
+	fprintf(history, "quarantine_set\tquarantine_broken\tFAIL\t%lu\t1000\tFPFPFP\n", body_size(quarantine_broken));
+	fprintf(history, "quarantine_set\tquarantine_steady\tPASS\t%lu\t1000\tPPPPPPPP\n", body_size(quarantine_steady));
+	fprintf(history, "quarantine_set\tquarantine_edited\tPASS\t%lu\t1000\tPFPFPFPF\n", body_size(quarantine_edited) + 1);
+	fclose(history);
+	setenv("SIGTEST_HISTORY", QUARANTINE_PATH, 0);
+	setenv("SIGTEST_QUARANTINE", "1", 0);
+	setenv("SIGTEST_RETRIES", "2", 0);
+
+	// Register the test sets
+	testset("quarantine_check_set", quarantine_check_config, NULL);
+	testcase("quarantine_check_flaky", quarantine_check_flaky);
+	testcase("quarantine_check_broken", quarantine_check_broken);
+	testcase("quarantine_check_unflagged", quarantine_check_unflagged);
+
+	testset("quarantine_set", quarantine_config, NULL);
+	testcase("quarantine_flaky", quarantine_flaky);
+	testcase("quarantine_broken", quarantine_broken);
+	testcase("quarantine_steady", quarantine_steady);
+	testcase("quarantine_edited", quarantine_edited);
+}
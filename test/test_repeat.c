@@ -0,0 +1,103 @@
+// test_repeat.c
+#include "sigtest_internal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+/*
+ * Test cases for the repeat modes: every case runs 20 times, spread over two forked workers,
+ * and is reported once. A flaky case fails one run in five and a case that crashes once costs
+ * its worker one run (so this executable exits with failures); the check set reads the stats
+ * of the cases before it.
+ */
+#define REPEAT_RUNS 20
+
+// call counts shared with the workers
+static unsigned long long *calls = NULL;
+enum
+{
+	STEADY,
+	FLAKY,
+	CRASH_ONCE,
+};
+
+static void repeat_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_repeat_check.log", "w");
+}
+static void repeat_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_repeat.log", "w");
+}
+
+void repeat_steady(void)
+{
+	__atomic_add_fetch(&calls[STEADY], 1, __ATOMIC_RELAXED);
+	Assert.isTrue(1 == 1, "a steady case should pass every run");
+}
+void repeat_flaky(void)
+{
+	unsigned long long call = __atomic_add_fetch(&calls[FLAKY], 1, __ATOMIC_RELAXED);
+	Assert.isTrue(call % 5 != 0, "call %llu of the flaky case fails", call);
+}
+void repeat_crash_once(void)
+{
+	if (__atomic_add_fetch(&calls[CRASH_ONCE], 1, __ATOMIC_RELAXED) == 3)
+		abort();
+}
+
+void repeat_check_steady(void)
+{
+	TestCase tc = find_testcase("repeat_set", "repeat_steady", NULL);
+	Assert.isTrue(tc && tc->repeat, "the steady case should carry repeat stats");
+	RepeatStats *stats = tc->repeat;
+	unsigned long long histogram = 0;
+	for (int bucket = 0; bucket < REPEAT_BUCKETS; bucket++)
+		histogram += stats->histogram[bucket];
+	Assert.isTrue(stats->runs == REPEAT_RUNS, "expected %d runs, got %llu", REPEAT_RUNS, stats->runs);
+	Assert.isTrue(calls[STEADY] == REPEAT_RUNS, "the body should run once per run, ran %llu times", calls[STEADY]);
+	Assert.isTrue(stats->states[PASS] == REPEAT_RUNS && !stats->failures, "every run should pass");
+	Assert.isTrue(histogram == REPEAT_RUNS, "the histogram should count every run, counted %llu", histogram);
+	Assert.isTrue(stats->min_ns <= repeat_percentile(stats, 0.5) && repeat_percentile(stats, 0.99) <= stats->max_ns,
+					  "percentiles should fall between the fastest and slowest run");
+	Assert.isTrue(tc->test_result.state == PASS, "the steady case should be reported as passed");
+}
+void repeat_check_flaky(void)
+{
+	TestCase tc = find_testcase("repeat_set", "repeat_flaky", NULL);
+	Assert.isTrue(tc && tc->repeat, "the flaky case should carry repeat stats");
+	RepeatStats *stats = tc->repeat;
+	Assert.isTrue(stats->runs == REPEAT_RUNS, "expected %d runs, got %llu", REPEAT_RUNS, stats->runs);
+	Assert.isTrue(stats->failures == 4 && stats->states[FAIL] == 4, "one run in five should fail, %llu did", stats->failures);
+	Assert.isTrue(stats->first_failure >= 1 && stats->first_failure <= REPEAT_RUNS, "the first failure should be a run number");
+	Assert.isTrue(tc->test_result.state == FAIL, "the flaky case should be reported as failed");
+}
+void repeat_check_crash(void)
+{
+	TestCase tc = find_testcase("repeat_set", "repeat_crash_once", NULL);
+	Assert.isTrue(tc && tc->repeat, "the crashing case should carry repeat stats");
+	RepeatStats *stats = tc->repeat;
+	Assert.isTrue(stats->runs == REPEAT_RUNS, "a lost worker should be replaced; got %llu runs", stats->runs);
+	Assert.isTrue(stats->states[CRASH] == 1 && stats->states[PASS] == REPEAT_RUNS - 1, "one run should crash");
+	Assert.isTrue(tc->test_result.state == CRASH, "the crashing case should be reported as crashed");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_repeat_tests(void)
+{
+	// opt in before the runner starts; the environment still wins
+	setenv("SIGTEST_REPEAT", "20", 0);
+	setenv("SIGTEST_WORKERS", "2", 0);
+	calls = mmap(NULL, sizeof(unsigned long long) * 3, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+	// Register the test sets
+	testset("repeat_check_set", repeat_check_config, NULL);
+	testcase("repeat_check_steady", repeat_check_steady);
+	testcase("repeat_check_flaky", repeat_check_flaky);
+	testcase("repeat_check_crash", repeat_check_crash);
+
+	testset("repeat_set", repeat_config, NULL);
+	testcase("repeat_steady", repeat_steady);
+	testcase("repeat_flaky", repeat_flaky);
+	testcase("repeat_crash_once", repeat_crash_once);
+}
@@ -0,0 +1,62 @@
+// test_shuffle.c
+#include "sigtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for shuffled order: under a fixed seed the cases of a set run in a shuffled
+ * order that is the same on every run, so a failing order can be replayed. The seed is one
+ * that shuffles the check set after the set it checks.
+ */
+#define SHUFFLE_SEED "2024"
+
+static char ran[128] = "";
+
+static void shuffle_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_shuffle_check.log", "w");
+}
+static void shuffle_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_shuffle.log", "w");
+}
+
+void shuffle_a(void) { strcat(ran, "a,"); }
+void shuffle_b(void) { strcat(ran, "b,"); }
+void shuffle_c(void) { strcat(ran, "c,"); }
+void shuffle_d(void) { strcat(ran, "d,"); }
+void shuffle_e(void) { strcat(ran, "e,"); }
+void shuffle_f(void) { strcat(ran, "f,"); }
+
+void shuffle_permuted(void)
+{
+	Assert.isTrue(strlen(ran) == 12, "every case should run once, ran %s", ran);
+	for (const char *name = "abcdef"; *name; name++)
+		Assert.isTrue(strchr(ran, *name) != NULL, "case %c should have run, ran %s", *name, ran);
+	Assert.isFalse(strcmp(ran, "a,b,c,d,e,f,") == 0, "the cases should not run in declared order");
+}
+void shuffle_replayed(void)
+{
+	// the order this seed has always produced; a change breaks replaying recorded seeds
+	Assert.stringEqual("d,f,a,c,b,e,", ran, 1, "seed " SHUFFLE_SEED " should replay its order, ran %s", ran);
+}
+
+// Register test cases
+__attribute__((constructor)) void init_shuffle_tests(void)
+{
+	// opt in before the runner starts; the environment still wins
+	setenv("SIGTEST_SHUFFLE", SHUFFLE_SEED, 0);
+
+	testset("shuffle_check_set", shuffle_check_config, NULL);
+	testcase("shuffle_permuted", shuffle_permuted);
+	testcase("shuffle_replayed", shuffle_replayed);
+
+	testset("shuffle_set", shuffle_config, NULL);
+	testcase("shuffle_a", shuffle_a);
+	testcase("shuffle_b", shuffle_b);
+	testcase("shuffle_c", shuffle_c);
+	testcase("shuffle_d", shuffle_d);
+	testcase("shuffle_e", shuffle_e);
+	testcase("shuffle_f", shuffle_f);
+}
@@ -0,0 +1,73 @@
+// test_tags.c
+#include "sigtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test cases for tag selection: set tags reach every case of the set, case tags add to
+ * them, and `fast & !flaky` runs only the fast cases that are not flaky.
+ */
+static int ran = 0;
+
+static void tags_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_tags_check.log", "w");
+}
+static void tags_fast_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_tags_fast.log", "w");
+}
+static void tags_mixed_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_tags_mixed.log", "w");
+}
+
+void tags_selected(void)
+{
+	ran++;
+	Assert.isTrue(1 == 1, "a fast case should run");
+}
+void tags_unselected(void)
+{
+	Assert.fail("a case the selection leaves out should not run");
+}
+void tags_ran(void)
+{
+	Assert.isTrue(ran == 3, "only the fast, steady cases should run, but %d did", ran);
+}
+void tags_names(void)
+{
+	char names[64];
+	tag_names(tag_mask("db,fast"), names, sizeof(names));
+	// names come back in registration order
+	Assert.stringEqual("fast,db", names, 1, "tag names should round-trip, but were %s", names);
+	// names the selection parser cannot read are refused when registered
+	tag_names(tag_mask("a&b,db,\"quoted\""), names, sizeof(names));
+	Assert.stringEqual("db", names, 1, "only the valid name should register, but got %s", names);
+}
+
+// Register test cases
+__attribute__((constructor)) void init_tags_tests(void)
+{
+	setenv("SIGTEST_TAGS", "fast & !flaky", 0);
+
+	// Register the test sets
+	testset("tags_check_set", tags_check_config, NULL);
+	testcase("tags_ran", tags_ran);
+	testcase("tags_names", tags_names);
+	tag_testset("fast");
+
+	testset("tags_fast_set", tags_fast_config, NULL);
+	tag_testset("fast");
+	testcase("tags_by_set", tags_selected);
+	testcase_tagged("tags_flaky", tags_unselected, "flaky");
+	testcase_tagged("tags_db", tags_selected, "db");
+
+	testset("tags_mixed_set", tags_mixed_config, NULL);
+	testcase("tags_untagged", tags_unselected);
+	testcase_tagged("tags_slow", tags_unselected, "db,nightly");
+	fail_testcase("tags_fast_expected_failure", tags_unselected);
+	tag_testcase("fast");
+	testcase_tagged("tags_fast", tags_selected, "fast, db");
+}
@@ -0,0 +1,56 @@
+// test_timeout.c
+#include "sigtest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/*
+ * Test cases for test body timeouts; both hung cases are expected to report TIMEOUT
+ * (so this executable exits with failures) while the run carries on to the end.
+ */
+static volatile unsigned long sink = 0;
+
+static void set_config(FILE **log_stream)
+{
+	// initialize the log stream
+	*log_stream = fopen("logs/test_timeout.log", "w");
+}
+
+void timeout_spin_forever(void)
+{
+	for (;;)
+	{
+		sink++;
+	}
+}
+void timeout_sleep_forever(void)
+{
+	for (;;)
+	{
+		sleep(1);
+	}
+}
+void timeout_within_budget(void)
+{
+	usleep(1000);
+	Assert.isTrue(1 == 1, "1 should equal 1");
+}
+void timeout_runner_recovered(void)
+{
+	Assert.isTrue(sink > 0, "the spinning case should have run before it was abandoned");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_timeout_tests(void)
+{
+	// Register the test set
+	testset("timeout_set", set_config, NULL);
+	timeout_testset(100);
+
+	// Register the test cases
+	testcase("timeout_spin_forever", timeout_spin_forever);
+	timeout_testcase(50);
+	testcase("timeout_sleep_forever", timeout_sleep_forever);
+	testcase("timeout_within_budget", timeout_within_budget);
+	testcase("timeout_runner_recovered", timeout_runner_recovered);
+}
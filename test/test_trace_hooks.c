@@ -0,0 +1,64 @@
+// test_trace_hooks.c
+#include "hooks/trace_hooks.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Test case for the Chrome trace hooks; open `logs/test_trace_hooks.json` in
+ * chrome://tracing or ui.perfetto.dev.
+ */
+static int fixture = 0;
+
+static void set_config(FILE **log_stream)
+{
+	// initialize the log stream
+	*log_stream = fopen("logs/test_trace_hooks.log", "w");
+}
+static void set_cleanup(void)
+{
+	fixture = 0;
+}
+static void trace_setup(void)
+{
+	fixture = 1;
+}
+static void trace_teardown(void)
+{
+	fixture = 0;
+}
+
+void trace_test_fixture(void)
+{
+	Assert.isTrue(fixture == 1, "setup should run ahead of the body");
+}
+void trace_test_fail(void)
+{
+	Assert.isTrue(1 == 0, "1 should not equal 0");
+}
+void trace_test_skip(void)
+{
+	Assert.skip("This test is skipped");
+}
+
+// Register test cases
+__attribute__((constructor)) void init_trace_tests(void)
+{
+	static struct TraceHookContext ctx = {
+		 .path = "logs/test_trace_hooks.json",
+		 .origin = 0,
+		 .flushed = 0,
+	};
+	// Register the test set
+	testset("trace_set", set_config, set_cleanup);
+
+	// Register the test hooks
+	trace_hooks.context = &ctx;
+	register_hooks((SigtestHooks)&trace_hooks);
+
+	// Register the test cases
+	setup_testcase(trace_setup);
+	teardown_testcase(trace_teardown);
+	testcase("trace_test_fixture", trace_test_fixture);
+	fail_testcase("trace_test_fail", trace_test_fail);
+	testcase("trace_test_skip", trace_test_skip);
+}
@@ -0,0 +1,142 @@
+// test_trend.c
+#define _GNU_SOURCE
+#include "sigtest_internal.h"
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Test cases for duration trends from a result store left by "earlier runs": a case running far
+ * over the median of its recent passes is a regression; one running under it, one with too few
+ * passes to judge and one edited since are not.
+ */
+#define TREND_PATH "logs/test_trend.history"
+#define TREND_REPORT "logs/test_trend.trend"
+
+static void trend_check_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_trend_check.log", "w");
+}
+static void trend_config(FILE **log_stream)
+{
+	*log_stream = fopen("logs/test_trend.log", "w");
+}
+
+void trend_slow(void)
+{
+	usleep(2000);
+	Assert.isTrue(1 == 1, "the slow case passes, slowly");
+}
+void trend_fast(void)
+{
+	Assert.isTrue(1 == 1, "the fast case runs under its median");
+}
+void trend_thin(void)
+{
+	usleep(2000);
+	Assert.isTrue(1 == 1, "two passes are too few to judge");
+}
+void trend_edited(void)
+{
+	usleep(2000);
+	Assert.isTrue(1 == 1, "the times of an earlier body should not count");
+}
+
+static char *read_file(const char *path)
+{
+	FILE *in = fopen(path, "r");
+	if (!in)
+		return NULL;
+	fseek(in, 0, SEEK_END);
+	long size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+	char *data = calloc(1, size + 1);
+	if (data && fread(data, 1, size, in) != (size_t)size)
+	{
+		free(data);
+		data = NULL;
+	}
+	fclose(in);
+
+	return data;
+}
+
+void trend_check_baseline(void)
+{
+	History *history = history_open(TREND_PATH);
+	Assert.isNotNull(history, "the store should open");
+	double median_ns = 0.0, mad_ns = 0.0;
+	TestSet set = NULL;
+	TestCase slow = find_testcase("trend_set", "trend_slow", &set);
+	int samples = history_baseline(history, set, slow, &median_ns, &mad_ns);
+	Assert.isTrue(samples == 8 && median_ns == 1000.0 && mad_ns == 0.0, "the baseline should be the median of 8 passes");
+	TestCase edited = find_testcase("trend_set", "trend_edited", NULL);
+	Assert.isTrue(history_baseline(history, set, edited, &median_ns, &mad_ns) == 0, "a changed body should have no baseline");
+	history_close(history);
+}
+void trend_check_report(void)
+{
+	History *history = history_open(TREND_PATH);
+	Trend *trend = trend_open(TREND_SLOWDOWN, 3);
+	TestSet set = NULL;
+	find_testcase("trend_set", "trend_slow", &set);
+	for (TestCase tc = set->cases; tc; tc = tc->next)
+		trend_record(trend, history, set, tc);
+	int regressions = trend_report(trend, TREND_REPORT);
+	trend_close(trend);
+	history_close(history);
+
+	Assert.isTrue(regressions == 1, "only the slow case should regress, got %d", regressions);
+	char *report = read_file(TREND_REPORT);
+	Assert.isNotNull(report, "the report should be written");
+	char *slowest = strstr(report, "Slowest 3 cases:");
+	char *regressed = strstr(report, "trend_set/trend_slow");
+	int listed = regressed && slowest && regressed < slowest && !strstr(slowest, "trend_set/trend_fast");
+	int totals = strstr(report, "Set totals") && strstr(report, "trend_set ") != NULL;
+	free(report);
+	Assert.isTrue(listed, "the slow case should be listed as a regression, the fast one not among the slowest");
+	Assert.isTrue(totals, "the set total should be listed");
+}
+
+//	the fingerprint the store keeps for an unchanged body
+static unsigned long body_size(void (*func)(void))
+{
+	Dl_info info;
+	const ElfW(Sym) *symbol = NULL;
+	if (!dladdr1((void *)func, &info, (void **)&symbol, RTLD_DL_SYMENT) || !symbol)
+		return 0;
+
+	return (unsigned long)symbol->st_size;
+}
+
+// Register test cases
+__attribute__((constructor)) void init_trend_tests(void)
+{
+	// the earlier runs: every case passed in about a microsecond, or a millisecond for the fast one
+	const char *times = "1000,1000,1000,1000,1000,1000,1000,1000";
+	FILE *history = fopen(TREND_PATH, "w");
+	fprintf(history, "# sigtest history v3\n");
+	fprintf(history, "trend_set\ttrend_slow\tPASS\t%lu\t1000\tPPPPPPPP\t%s\n", body_size(trend_slow), times);
+	fprintf(history, "trend_set\ttrend_fast\tPASS\t%lu\t1000000\tPPPP\t1000000,1000000,1000000,1000000,1000000\n",
+			  body_size(trend_fast));
+	fprintf(history, "trend_set\ttrend_thin\tPASS\t%lu\t1000\tPP\t1000,1000\n", body_size(trend_thin));
+	fprintf(history, "trend_set\ttrend_edited\tPASS\t%lu\t1000\tPPPPPPPP\t%s\n", body_size(trend_edited) + 1, times);
+	fclose(history);
+	setenv("SIGTEST_HISTORY", TREND_PATH, 0);
+	setenv("SIGTEST_TREND", "logs/test_trend_run.trend", 0);
+	setenv("SIGTEST_MAX_REGRESSIONS", "1", 0);
+
+	// Register the test sets
+	testset("trend_check_set", trend_check_config, NULL);
+	testcase("trend_check_baseline", trend_check_baseline);
+	testcase("trend_check_report", trend_check_report);
+
+	testset("trend_set", trend_config, NULL);
+	testcase("trend_slow", trend_slow);
+	testcase("trend_fast", trend_fast);
+	testcase("trend_thin", trend_thin);
+	testcase("trend_edited", trend_edited);
+}
@@ -0,0 +1,510 @@
+/* tools/sigconvert.c */
+#include "hooks/binary_hooks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+   Converts a binary result stream (see `include/hooks/binary_hooks.h`) into the
+   JSON layout of `json_hooks` or the JUnit XML layout of `junit_hooks`.
+*/
+
+static int verbose = 0;
+
+typedef enum
+{
+   FORMAT_JSON,
+   FORMAT_JUNIT,
+} OutputFormat;
+
+// read cursor over a single record payload
+typedef struct
+{
+   const unsigned char *data;
+   size_t len;
+   size_t pos;
+   int error;
+} Reader;
+
+// a decoded string; not NUL-terminated
+typedef struct
+{
+   const char *str;
+   int len;
+} Slice;
+
+static const char *STATE_NAMES[] = {
+    "PASS",
+    "FAIL",
+    "SKIP",
+    "TIMEOUT",
+    "CRASH",
+    "NOT_RUN",
+};
+
+// mirrors TEST_PHASES; the converter does not link the runner
+static const char *PHASE_NAMES[] = {
+    "before_test",
+    "setup",
+    "body",
+    "teardown",
+    "after_test",
+    "result",
+};
+
+static uint64_t get_uint(Reader *rd, int bytes);
+static Slice get_str(Reader *rd);
+static void write_escaped(FILE *out, Slice text, OutputFormat format);
+static int convert(const unsigned char *data, size_t len, OutputFormat format, FILE *out);
+
+int main(int argc, char *argv[])
+{
+   const char *input_file = NULL;
+   const char *output_file = NULL;
+   OutputFormat format = FORMAT_JSON;
+
+   // Parse arguments
+   for (int i = 1; i < argc; i++)
+   {
+      if (strcmp(argv[i], "-v") == 0)
+      {
+         verbose = 1;
+      }
+      else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+      {
+         const char *name = argv[++i];
+         if (strcmp(name, "json") == 0)
+            format = FORMAT_JSON;
+         else if (strcmp(name, "junit") == 0)
+            format = FORMAT_JUNIT;
+         else
+         {
+            fprintf(stderr, "Unknown format: %s\n", name);
+            return 1;
+         }
+      }
+      else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+      {
+         output_file = argv[++i];
+      }
+      else if (argv[i][0] != '-')
+      {
+         input_file = argv[i];
+      }
+   }
+
+   if (!input_file)
+   {
+      fprintf(stderr, "Usage: %s [-v] [-f json|junit] [-o <output>] <input.bin>\n", argv[0]);
+      return 1;
+   }
+
+   // Read the whole stream; records are decoded in place
+   FILE *in = fopen(input_file, "rb");
+   if (!in)
+   {
+      char err_msg[256];
+      snprintf(err_msg, sizeof(err_msg), "Error opening input file: %s", input_file);
+      perror(err_msg);
+      return 1;
+   }
+   fseek(in, 0, SEEK_END);
+   long size = ftell(in);
+   fseek(in, 0, SEEK_SET);
+   unsigned char *data = malloc(size > 0 ? size : 1);
+   if (!data)
+   {
+      perror("Error allocating input buffer");
+      fclose(in);
+      return 1;
+   }
+   if (size > 0 && fread(data, 1, size, in) != (size_t)size)
+   {
+      perror("Error reading input file");
+      free(data);
+      fclose(in);
+      return 1;
+   }
+   fclose(in);
+
+   FILE *out = output_file ? fopen(output_file, "w") : stdout;
+   if (!out)
+   {
+      perror("Error opening output file");
+      free(data);
+      return 1;
+   }
+   if (verbose)
+   {
+      fprintf(stderr, "Converting %s (%ld bytes) -> %s\n", input_file, size, output_file ? output_file : "stdout");
+   }
+
+   int result = convert(data, (size_t)size, format, out);
+
+   if (out != stdout)
+      fclose(out);
+   free(data);
+
+   return result;
+}
+
+// decoding helpers
+static uint64_t get_uint(Reader *rd, int bytes)
+{
+   if (rd->pos + bytes > rd->len)
+   {
+      rd->error = 1;
+      return 0;
+   }
+
+   uint64_t value = 0;
+   for (int i = 0; i < bytes; i++)
+      value |= (uint64_t)rd->data[rd->pos + i] << (i * 8);
+   rd->pos += bytes;
+
+   return value;
+}
+static Slice get_str(Reader *rd)
+{
+   Slice slice = {"", 0};
+   size_t len = (size_t)get_uint(rd, 2);
+   if (rd->error || rd->pos + len > rd->len)
+   {
+      rd->error = 1;
+      return slice;
+   }
+
+   slice.str = (const char *)rd->data + rd->pos;
+   slice.len = (int)len;
+   rd->pos += len;
+
+   return slice;
+}
+// escape text for a JSON string or an XML attribute value
+static void write_escaped(FILE *out, Slice text, OutputFormat format)
+{
+   for (int i = 0; i < text.len; i++)
+   {
+      unsigned char c = (unsigned char)text.str[i];
+      if (format == FORMAT_JUNIT)
+      {
+         if (c == '"')
+            fputs("&quot;", out);
+         else if (c == '&')
+            fputs("&amp;", out);
+         else if (c == '<')
+            fputs("&lt;", out);
+         else if (c == '>')
+            fputs("&gt;", out);
+         else if (c < 0x20)
+            fprintf(out, "&#%u;", c);
+         else
+            fputc(c, out);
+      }
+      else if (c == '"' || c == '\\')
+         fprintf(out, "\\%c", c);
+      else if (c < 0x20)
+         fprintf(out, "\\u%04x", c);
+      else
+         fputc(c, out);
+   }
+}
+// step to the next record, passing over the header of any stream concatenated after the first;
+// returns 1 with the record's type and payload, 0 at the end of the stream, -1 on a bad stream
+static int next_record(const unsigned char *data, size_t len, size_t *pos, BinaryRecordType *type, Reader *rd)
+{
+   while (*pos + 4 <= len && memcmp(data + *pos, BINARY_STREAM_MAGIC, 4) == 0)
+   {
+      Reader header = {data, len, *pos + 4, 0};
+      unsigned version = (unsigned)get_uint(&header, 2);
+      if (header.error || *pos + BINARY_HEADER_SIZE > len)
+      {
+         fprintf(stderr, "Error: Truncated stream header at offset %zu\n", *pos);
+         return -1;
+      }
+      if (version > BINARY_STREAM_VERSION)
+      {
+         fprintf(stderr, "Error: Unsupported stream version %u\n", version);
+         return -1;
+      }
+      *pos += BINARY_HEADER_SIZE;
+   }
+   if (*pos + BINARY_RECORD_HEADER_SIZE > len)
+      return 0;
+
+   Reader frame = {data, len, *pos, 0};
+   *type = (BinaryRecordType)get_uint(&frame, 1);
+   size_t payload_len = (size_t)get_uint(&frame, 4);
+   if (frame.pos + payload_len > len)
+   {
+      fprintf(stderr, "Error: Truncated record at offset %zu\n", *pos);
+      return -1;
+   }
+   *rd = (Reader){data + frame.pos, payload_len, 0, 0};
+   *pos = frame.pos + payload_len;
+
+   return 1;
+}
+// close a set whose summary record never came, e.g. when the run died mid-set
+static void close_set(FILE *out, OutputFormat format, int pending_case)
+{
+   if (format == FORMAT_JSON)
+   {
+      if (pending_case)
+         fprintf(out, "    }\n");
+      fprintf(out, "  ]\n");
+      fprintf(out, "}");
+   }
+   else
+   {
+      fprintf(out, "</testsuite>\n");
+   }
+}
+
+static int convert(const unsigned char *data, size_t len, OutputFormat format, FILE *out)
+{
+   if (len < BINARY_HEADER_SIZE || memcmp(data, BINARY_STREAM_MAGIC, 4) != 0)
+   {
+      fprintf(stderr, "Error: Not a binary result stream\n");
+      return 1;
+   }
+
+   // one document per stream: a lone set keeps the json_hooks layout, several become an array
+   size_t pos = 0;
+   BinaryRecordType type;
+   Reader rd;
+   int sets = 0, step;
+   while ((step = next_record(data, len, &pos, &type, &rd)) > 0)
+   {
+      if (type == REC_SET_START)
+         sets++;
+   }
+   if (step < 0)
+      return 1;
+
+   int as_array = format == FORMAT_JSON && sets != 1;
+   if (as_array)
+      fprintf(out, "[");
+   else if (format == FORMAT_JUNIT)
+   {
+      fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+      fprintf(out, "<testsuites>\n");
+   }
+
+   pos = 0;
+   int in_set = 0;       // a set awaiting its summary
+   int pending_case = 0; // JSON: a case object awaiting its closing brace
+   int written = 0;      // sets opened so far
+   int records = 0;
+
+   while ((step = next_record(data, len, &pos, &type, &rd)) > 0)
+   {
+      size_t offset = (size_t)((const unsigned char *)rd.data - data) - BINARY_RECORD_HEADER_SIZE;
+      records++;
+
+      // cases and summaries outside a set have nothing to attach to
+      if (!in_set && (type == REC_CASE_RESULT || type == REC_SET_SUMMARY))
+      {
+         fprintf(stderr, "Error: Record outside a test set at offset %zu\n", offset);
+         return 1;
+      }
+
+      switch (type)
+      {
+      case REC_SET_START:
+      {
+         get_uint(&rd, 4); // sequence
+         int count = (int)get_uint(&rd, 4);
+         time_t stamp = (time_t)get_uint(&rd, 8);
+         Slice name = get_str(&rd);
+
+         if (in_set)
+            close_set(out, format, pending_case);
+         if (format == FORMAT_JSON)
+         {
+            char timestamp[32];
+            strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", localtime(&stamp));
+            if (as_array)
+               fprintf(out, written ? ",\n" : "\n");
+            fprintf(out, "{\n");
+            fprintf(out, "  \"test_set\": \"");
+            write_escaped(out, name, format);
+            fprintf(out, "\",\n");
+            fprintf(out, "  \"timestamp\": \"%s\",\n", timestamp);
+            fprintf(out, "  \"tests\": [\n");
+         }
+         else
+         {
+            fprintf(out, "<testsuite name=\"");
+            write_escaped(out, name, format);
+            fprintf(out, "\" tests=\"%d\">\n", count);
+         }
+         in_set = 1;
+         pending_case = 0;
+         written++;
+
+         break;
+      }
+      case REC_CASE_RESULT:
+      {
+         unsigned state = (unsigned)get_uint(&rd, 1);
+         get_uint(&rd, 1); // flags
+         uint64_t duration_ns = get_uint(&rd, 8);
+         Slice name = get_str(&rd);
+         Slice message = get_str(&rd);
+         // phase timings were appended to the record; older streams end here
+         uint64_t phase_ns[PHASE_COUNT] = {0};
+         int has_phases = rd.pos + 8 * PHASE_COUNT <= rd.len;
+         for (int phase = 0; has_phases && phase < PHASE_COUNT; phase++)
+            phase_ns[phase] = get_uint(&rd, 8);
+         // then the comma-separated tags
+         Slice tags = {"", 0};
+         if (has_phases && rd.pos + 2 <= rd.len)
+            tags = get_str(&rd);
+         const char *status = state < sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]) ? STATE_NAMES[state] : "UNKNOWN";
+
+         if (format == FORMAT_JSON)
+         {
+            char duration_str[32];
+            snprintf(duration_str, sizeof(duration_str), "%.3f", duration_ns / 1000.0);
+
+            if (pending_case)
+               fprintf(out, "    },\n");
+            fprintf(out, "    {\n");
+            fprintf(out, "      \"test\": \"");
+            write_escaped(out, name, format);
+            fprintf(out, "\",\n");
+            fprintf(out, "      \"status\": \"%s\",\n", status);
+            if (tags.len)
+            {
+               fprintf(out, "      \"tags\": [\"");
+               for (int i = 0; i < tags.len; i++)
+               {
+                  if (tags.str[i] == ',')
+                     fprintf(out, "\", \"");
+                  else
+                     write_escaped(out, (Slice){tags.str + i, 1}, format);
+               }
+               fprintf(out, "\"],\n");
+            }
+            fprintf(out, "      \"duration_us\": \"%s\",\n", duration_str);
+            if (has_phases)
+            {
+               fprintf(out, "      \"phases_us\": {");
+               for (int phase = 0; phase < PHASE_COUNT; phase++)
+                  fprintf(out, "%s\"%s\": %.3f", phase ? ", " : "", PHASE_NAMES[phase], phase_ns[phase] / 1000.0);
+               fprintf(out, "},\n");
+            }
+            fprintf(out, "      \"message\": \"");
+            write_escaped(out, message, format);
+            fprintf(out, "\"\n");
+            pending_case = 1;
+         }
+         else
+         {
+            fprintf(out, "<testcase name=\"");
+            write_escaped(out, name, format);
+            fprintf(out, "\" time=\"%.6f\">\n", duration_ns / 1e9);
+            if (tags.len)
+            {
+               fprintf(out, "<properties><property name=\"tags\" value=\"");
+               write_escaped(out, tags, format);
+               fprintf(out, "\"/></properties>\n");
+            }
+            if (state == FAIL || state == TIMEOUT || state == CRASH)
+            {
+               fprintf(out, "<failure message=\"");
+               if (message.len)
+                  write_escaped(out, message, format);
+               else
+                  fprintf(out, "Unknown failure");
+               fprintf(out, "\"/>\n");
+            }
+            else if ((state == SKIP && message.len) || state == NOT_RUN)
+            {
+               fprintf(out, "<skipped message=\"");
+               write_escaped(out, message, format);
+               fprintf(out, "\"/>\n");
+            }
+            else if (state == SKIP)
+            {
+               fprintf(out, "<skipped/>\n");
+            }
+            fprintf(out, "</testcase>\n");
+         }
+
+         break;
+      }
+      case REC_SET_SUMMARY:
+      {
+         int total = (int)get_uint(&rd, 4);
+         int passed = (int)get_uint(&rd, 4);
+         int failed = (int)get_uint(&rd, 4);
+         int skipped = (int)get_uint(&rd, 4);
+         int has_timing = rd.pos + 16 <= rd.len;
+         uint64_t config_ns = has_timing ? get_uint(&rd, 8) : 0;
+         uint64_t cleanup_ns = has_timing ? get_uint(&rd, 8) : 0;
+         int has_not_run = rd.pos + 4 <= rd.len;
+         int not_run = has_not_run ? (int)get_uint(&rd, 4) : 0;
+
+         if (format == FORMAT_JSON)
+         {
+            if (pending_case)
+               fprintf(out, "    }\n");
+            fprintf(out, "  ],\n");
+            fprintf(out, "  \"summary\": {\n");
+            fprintf(out, "    \"total\": %d,\n", total);
+            fprintf(out, "    \"passed\": %d,\n", passed);
+            fprintf(out, "    \"failed\": %d,\n", failed);
+            fprintf(out, "    \"skipped\": %d%s\n", skipped, has_timing || has_not_run ? "," : "");
+            if (has_not_run)
+               fprintf(out, "    \"not_run\": %d%s\n", not_run, has_timing ? "," : "");
+            if (has_timing)
+            {
+               fprintf(out, "    \"config_us\": %.3f,\n", config_ns / 1000.0);
+               fprintf(out, "    \"cleanup_us\": %.3f\n", cleanup_ns / 1000.0);
+            }
+            fprintf(out, "  }\n");
+            fprintf(out, "}");
+         }
+         else
+         {
+            fprintf(out, "</testsuite>\n");
+         }
+         in_set = 0;
+         pending_case = 0;
+
+         break;
+      }
+      default:
+         // unknown record: skip it
+         records--;
+         break;
+      }
+
+      if (rd.error)
+      {
+         fprintf(stderr, "Error: Malformed record at offset %zu\n", offset);
+         return 1;
+      }
+   }
+   if (step < 0)
+      return 1;
+
+   if (in_set)
+      close_set(out, format, pending_case);
+   if (as_array)
+      fprintf(out, "%s]\n", written ? "\n" : "");
+   else if (format == FORMAT_JSON)
+      fprintf(out, "\n");
+   else
+      fprintf(out, "</testsuites>\n");
+
+   if (verbose)
+   {
+      fprintf(stderr, "records=%d\n", records);
+   }
+
+   return 0;
+}